@@ -0,0 +1,106 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <string>
+
+#include "include/algorithm-sort.hpp"
+#include "include/vector.hpp"
+
+#include "Game.hpp"
+#include "KeyNoteData.hpp"
+#include "Replay.hpp"
+
+// Simulated player: writes the key presses it would make for game.notes into
+// an InputLog. Bots only read the game and their own generator, so one bot
+// can play many games on many threads at once.
+struct Bot {
+  std::string name;
+  std::function<void(const Game &, std::mt19937 &, InputLog &)> play;
+};
+
+// Ideal hit time of a note: the middle of the PERFECT window, once it has
+// scrolled down to the judgement line
+inline double idealHitMs(const Game &game, const KeyNoteData &n) {
+  std::size_t hitFragment = n.startFragment + game.fragments;
+  return game.timing.timeOf(hitFragment) +
+         0.1 * game.timing.msPerFragmentAt(hitFragment);
+}
+
+// Shared note walker. `timingError(lane)` returns the press offset in ms
+// from the ideal time, `misses()` whether this note is skipped entirely.
+template <class TimingError, class Misses>
+void playNotes(const Game &game, InputLog &log, TimingError &&timingError,
+               Misses &&misses) {
+  log.reset(game.lanes, game.fragments, game.timing.uniformMs());
+
+  for (const KeyNoteData &n : game.notes) {
+    if (n.lane >= game.lanes || misses())
+      continue;
+
+    double pressMs = idealHitMs(game, n) + timingError(n.lane);
+    if (pressMs < 0)
+      pressMs = 0;
+
+    double releaseMs;
+    std::size_t hitFragment = n.startFragment + game.fragments;
+    if (n.holds > 0)
+      releaseMs = game.timing.timeOf(hitFragment + n.holds) - 1 +
+                  timingError(n.lane);
+    else
+      releaseMs = pressMs + game.timing.msPerFragmentAt(hitFragment) / 4.0;
+    if (releaseMs <= pressMs)
+      releaseMs = pressMs + 1;
+
+    log.record(static_cast<uint32_t>(pressMs), n.lane, true);
+    log.record(static_cast<uint32_t>(releaseMs), n.lane, false);
+  }
+
+  mystd::sort(log.events.begin(), log.events.end(),
+              [](const InputEvent &a, const InputEvent &b) {
+                return a.timeMs < b.timeMs;
+              });
+}
+
+inline Bot perfectBot() {
+  return {"perfect", [](const Game &game, std::mt19937 &, InputLog &log) {
+            playNotes(
+                game, log, [](std::size_t) { return 0.0; },
+                [] { return false; });
+          }};
+}
+
+// Gaussian press timing around the ideal time, plus a chance to not react
+// at all
+inline Bot humanBot(double sigmaMs, double missRate) {
+  return {"human(sigma=" + std::to_string((int)sigmaMs) + "ms)",
+          [sigmaMs, missRate](const Game &game, std::mt19937 &rng,
+                              InputLog &log) {
+            std::normal_distribution<double> error(0.0, sigmaMs);
+            std::bernoulli_distribution miss(missRate);
+            playNotes(
+                game, log, [&](std::size_t) { return error(rng); },
+                [&] { return miss(rng); });
+          }};
+}
+
+// Like humanBot, but timing gets worse the further right the lane is:
+// sigma * (1 + bias * lane / (lanes - 1))
+inline Bot laneBiasedBot(double sigmaMs, double missRate, double bias) {
+  return {"lane-biased(sigma=" + std::to_string((int)sigmaMs) + "ms)",
+          [sigmaMs, missRate, bias](const Game &game, std::mt19937 &rng,
+                                    InputLog &log) {
+            std::normal_distribution<double> error(0.0, 1.0);
+            std::bernoulli_distribution miss(missRate);
+            double lastLane = game.lanes > 1 ? double(game.lanes - 1) : 1.0;
+            playNotes(
+                game, log,
+                [&](std::size_t lane) {
+                  return error(rng) * sigmaMs * (1.0 + bias * lane / lastLane);
+                },
+                [&] { return miss(rng); });
+          }};
+}
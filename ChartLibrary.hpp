@@ -0,0 +1,278 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "include/vector.hpp"
+
+#include "ChartParser.hpp"
+#include "CompiledChart.hpp"
+#include "KeyNoteData.hpp"
+
+// What song select shows for one chart, without loading it
+struct ChartInfo {
+  std::string path;
+  uint64_t size = 0;
+  int64_t mtime = 0; // last_write_time ticks, only compared for equality
+  int bpm = 0;
+  int fragmentsPerBeat = 0;
+  uint32_t keyNotes = 0;
+  uint32_t mouseNotes = 0;
+  uint32_t lengthFragments = 0; // up to the end of the last note
+  uint32_t durationMs = 0;      // offset and tempo changes included
+  std::string musicFile;
+};
+
+struct LibraryScanStats {
+  std::size_t charts = 0;
+  std::size_t reused = 0; // taken from the index unchanged
+  std::size_t parsed = 0;
+  std::size_t failed = 0;
+  double ms = 0;
+};
+
+// Every *.txt chart under a directory, kept in an index file so that a
+// chart is only read again when its size or mtime changes. Changed charts
+// are parsed on all cores.
+//
+// Index format, one chart per line, tab separated:
+//   # RhythmQuest chart index 2
+//   size mtime bpm fragments keynotes mousenotes length durationMs music path
+class ChartLibrary {
+private:
+  static constexpr std::string_view INDEX_HEADER =
+      "# RhythmQuest chart index 2\n";
+
+  std::vector<ChartInfo> charts; // sorted by path
+
+  static bool nextField(std::string_view &rest, std::string_view &field) {
+    if (rest.empty())
+      return false;
+    std::size_t tab = rest.find('\t');
+    field = rest.substr(0, tab);
+    rest = tab == std::string_view::npos ? std::string_view()
+                                         : rest.substr(tab + 1);
+    return true;
+  }
+
+  template <class T> static bool number(std::string_view text, T &value) {
+    auto [ptr, ec] =
+        std::from_chars(text.data(), text.data() + text.size(), value);
+    return ec == std::errc() && ptr == text.data() + text.size();
+  }
+
+  static bool parseIndexLine(std::string_view line, ChartInfo &info) {
+    std::string_view f[10];
+    for (std::string_view &field : f)
+      if (!nextField(line, field))
+        return false;
+    if (!number(f[0], info.size) || !number(f[1], info.mtime) ||
+        !number(f[2], info.bpm) || !number(f[3], info.fragmentsPerBeat) ||
+        !number(f[4], info.keyNotes) || !number(f[5], info.mouseNotes) ||
+        !number(f[6], info.lengthFragments) || !number(f[7], info.durationMs))
+      return false;
+    info.musicFile.assign(f[8]);
+    info.path.assign(f[9]);
+    return true;
+  }
+
+  static void appendIndexLine(std::string &out, const ChartInfo &info) {
+    auto append = [&out](auto value) {
+      char buffer[24];
+      auto [end, ec] = std::to_chars(buffer, buffer + sizeof buffer, value);
+      out.append(buffer, end);
+      out += '\t';
+    };
+    append(info.size);
+    append(info.mtime);
+    append(info.bpm);
+    append(info.fragmentsPerBeat);
+    append(info.keyNotes);
+    append(info.mouseNotes);
+    append(info.lengthFragments);
+    append(info.durationMs);
+    out += info.musicFile;
+    out += '\t';
+    out += info.path;
+    out += '\n';
+  }
+
+  // Entries by path from the last index, empty if missing or outdated
+  static std::unordered_map<std::string, ChartInfo>
+  readIndex(const std::string &indexPath) {
+    std::unordered_map<std::string, ChartInfo> known;
+    MappedFile file;
+    if (!file.open(indexPath))
+      return known;
+    std::string_view text = file.view();
+    if (!text.starts_with(INDEX_HEADER))
+      return known;
+    text.remove_prefix(INDEX_HEADER.size());
+
+    while (!text.empty()) {
+      std::size_t end = text.find('\n');
+      std::string_view line = text.substr(0, end);
+      text = end == std::string_view::npos ? std::string_view()
+                                           : text.substr(end + 1);
+      ChartInfo info;
+      if (parseIndexLine(line, info))
+        known.emplace(info.path, std::move(info));
+    }
+    return known;
+  }
+
+  // Fills in everything but path, size and mtime
+  static bool summarize(ChartParser &parser,
+                        const mystd::vector<KeyNoteData> &notes,
+                        ChartInfo &info) {
+    MappedFile file;
+    if (!file.open(info.path))
+      return false;
+    parser.parse(file.view());
+
+    std::size_t length = 0;
+    for (const KeyNoteData &n : notes)
+      length = std::max<std::size_t>(length, n.startFragment +
+                                                 (n.holds > 0 ? n.holds : 1));
+    for (const MouseNoteData &m : parser.getMouseNotes())
+      length = std::max<std::size_t>(length, m.startFragment + 1);
+
+    info.bpm = parser.getBPM();
+    info.fragmentsPerBeat = parser.getFragmentsPerBeat();
+    info.keyNotes = static_cast<uint32_t>(notes.size());
+    info.mouseNotes = static_cast<uint32_t>(parser.getMouseNotes().size());
+    info.lengthFragments = static_cast<uint32_t>(length);
+    double duration = parser.getFragmentTime(length);
+    info.durationMs = duration > 0 ? static_cast<uint32_t>(duration) : 0;
+    info.musicFile = parser.getMusicFile();
+    return true;
+  }
+
+public:
+  // Lists `chartDir`, reuses index entries whose size and mtime still
+  // match, parses the rest on `threads` threads (0: all cores) and rewrites
+  // the index if anything changed. Charts that fail to load are left out.
+  LibraryScanStats scan(const std::string &chartDir,
+                        const std::string &indexPath, unsigned threads = 0) {
+    auto begin = std::chrono::steady_clock::now();
+    LibraryScanStats stats;
+    std::unordered_map<std::string, ChartInfo> known = readIndex(indexPath);
+
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    std::vector<ChartInfo> found;
+    for (fs::recursive_directory_iterator it(chartDir, ec), end;
+         !ec && it != end; it.increment(ec)) {
+      const fs::directory_entry &entry = *it;
+      std::string name = entry.path().filename().string();
+      if (!name.empty() && name[0] == '.') { // e.g. the .cache directory
+        if (entry.is_directory(ec))
+          it.disable_recursion_pending();
+        continue;
+      }
+      if (!entry.is_regular_file(ec) || entry.path().extension() != ".txt")
+        continue;
+
+      ChartInfo info;
+      info.path = entry.path().generic_string();
+      info.size = entry.file_size(ec);
+      info.mtime = entry.last_write_time(ec).time_since_epoch().count();
+      found.push_back(std::move(info));
+    }
+    if (ec)
+      std::cerr << "[WARNING] Chart directory " << chartDir << ": "
+                << ec.message() << std::endl;
+
+    // Unchanged charts come straight from the index
+    std::vector<std::size_t> stale;
+    for (std::size_t i = 0; i < found.size(); ++i) {
+      auto old = known.find(found[i].path);
+      if (old != known.end() && old->second.size == found[i].size &&
+          old->second.mtime == found[i].mtime) {
+        found[i] = std::move(old->second);
+        ++stats.reused;
+      } else {
+        stale.push_back(i);
+      }
+    }
+
+    // Parse the rest; workers pull indices from a counter and write only
+    // their own entries
+    std::vector<char> ok(found.size(), 1);
+    if (!stale.empty()) {
+      if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+      threads = std::min<std::size_t>(threads, stale.size());
+      std::atomic<std::size_t> next{0};
+      auto worker = [&] {
+        mystd::vector<KeyNoteData> notes; // reused for every chart
+        ChartParser parser(notes);
+        for (std::size_t job = next.fetch_add(1, std::memory_order_relaxed);
+             job < stale.size();
+             job = next.fetch_add(1, std::memory_order_relaxed)) {
+          std::size_t i = stale[job];
+          ok[i] = summarize(parser, notes, found[i]);
+        }
+      };
+      std::vector<std::thread> pool;
+      for (unsigned i = 1; i < threads; ++i)
+        pool.emplace_back(worker);
+      worker();
+      for (std::thread &t : pool)
+        t.join();
+    }
+
+    charts.clear();
+    for (std::size_t i = 0; i < found.size(); ++i) {
+      if (ok[i])
+        charts.push_back(std::move(found[i]));
+      else
+        ++stats.failed;
+    }
+    std::sort(charts.begin(), charts.end(),
+              [](const ChartInfo &a, const ChartInfo &b) {
+                return a.path < b.path;
+              });
+    stats.charts = charts.size();
+    stats.parsed = stale.size() - stats.failed;
+
+    if (!stale.empty() || known.size() != stats.reused) {
+      std::string index(INDEX_HEADER);
+      for (const ChartInfo &info : charts)
+        appendIndexLine(index, info);
+      if (!writeFileAtomically(indexPath, index))
+        std::cerr << "[WARNING] Cannot write chart index: " << indexPath
+                  << std::endl;
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    stats.ms = std::chrono::duration<double, std::milli>(end - begin).count();
+    return stats;
+  }
+
+  const std::vector<ChartInfo> &getCharts() const { return charts; }
+  std::size_t size() const { return charts.size(); }
+  bool empty() const { return charts.empty(); }
+  const ChartInfo &operator[](std::size_t i) const { return charts[i]; }
+
+  // Index of the chart at `path`, or `fallback`
+  std::size_t find(const std::string &path, std::size_t fallback = 0) const {
+    std::string wanted = std::filesystem::path(path).generic_string();
+    for (std::size_t i = 0; i < charts.size(); ++i)
+      if (charts[i].path == wanted)
+        return i;
+    return fallback;
+  }
+};
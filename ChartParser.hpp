@@ -1,18 +1,21 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <fstream>
-#include <sstream>
 #include <algorithm>
+#include <charconv>
 #include <iostream>
 #include <cstdint>
 #include <cstddef>
+#include <cmath>
 
 #include "include/vector.hpp"
-#include "include/qsort.hpp"
+#include "include/algorithm-sort.hpp"
 
 #include "KeyNoteData.hpp"
+#include "TimingMap.hpp"
 
 // 滑鼠物件結構（同學B使用）
 struct MouseNoteData {
@@ -21,265 +24,443 @@ struct MouseNoteData {
     int type;               // 0=GREEN(拾取), 1=RED(躲避)
 };
 
+// The whole file is read into one buffer and tokenized in place with
+// string_views; numbers go through from_chars, so parsing allocates nothing
+// per line or token and never throws on bad input.
 class ChartParser {
 private:
+    enum class Section { NONE, KEYNOTES, MOUSENOTES };
+
     int bpm;
     int offset;
     int fragmentsPerBeat;
     std::string musicFile;
     mystd::vector<KeyNoteData>& keyNotes;
     std::vector<MouseNoteData> mouseNotes;
+    std::string buffer; // file contents, reused between loads
+
+    // &bpmchange= / &stop= lines, placed by beat once fragmentsPerBeat is known
+    struct TimingLine {
+        double beat;
+        bool stop;
+        double value;
+    };
+    std::vector<TimingLine> timingLines;
+    TimingMap timing;
+
+    static bool isSpace(char c) {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+    }
+
+    static std::string_view trim(std::string_view str) {
+        const char* begin = str.data();
+        const char* end = begin + str.size();
+        while (begin < end && isSpace(*begin)) ++begin;
+        while (end > begin && isSpace(end[-1])) --end;
+        return std::string_view(begin, end - begin);
+    }
+
+    // Leading integer of str, like std::stoi without the exceptions
+    static bool parseInt(std::string_view str, int& value) {
+        const char* begin = str.data();
+        const char* end = begin + str.size();
+        auto [ptr, ec] = std::from_chars(begin, end, value);
+        return ec == std::errc() && ptr != begin;
+    }
 
-    std::string trim(const std::string& str) {
-        size_t first = str.find_first_not_of(" \t\r\n");
-        if (first == std::string::npos) return "";
-        size_t last = str.find_last_not_of(" \t\r\n");
-        return str.substr(first, last - first + 1);
+    // "<beat>,<value>", both may have a fraction
+    static bool parsePair(std::string_view str, double& first, double& second) {
+        const char* end = str.data() + str.size();
+        auto [comma, ec] = std::from_chars(str.data(), end, first);
+        if (ec != std::errc() || comma == end || *comma != ',') return false;
+        auto [rest, ec2] = std::from_chars(comma + 1, end, second);
+        return ec2 == std::errc() && rest != comma + 1;
     }
-    
-    void parseMetadata(const std::string& line) {
-        if (line.find("&bpm=") == 0) {
-            bpm = std::stoi(line.substr(5));
-        } else if (line.find("&offset=") == 0) {
-            offset = std::stoi(line.substr(8));
-        } else if (line.find("&music=") == 0) {
-            musicFile = line.substr(7);
-        } else if (line.find("&fragments=") == 0) {
-            fragmentsPerBeat = std::stoi(line.substr(11));
+
+    void parseMetadata(std::string_view line) {
+        int value;
+        if (line.starts_with("&bpm=")) {
+            if (parseInt(line.substr(5), value)) bpm = value;
+        } else if (line.starts_with("&offset=")) {
+            if (parseInt(line.substr(8), value)) offset = value;
+        } else if (line.starts_with("&music=")) {
+            musicFile.assign(line.substr(7));
+        } else if (line.starts_with("&fragments=")) {
+            if (parseInt(line.substr(11), value)) fragmentsPerBeat = value;
+        } else if (line.starts_with("&bpmchange=") || line.starts_with("&stop=")) {
+            bool stop = line[1] == 's';
+            double beat, amount;
+            if (parsePair(line.substr(stop ? 6 : 11), beat, amount) &&
+                beat >= 0 && amount > 0)
+                timingLines.push_back({beat, stop, amount});
+            else
+                std::cerr << "[WARNING] Invalid timing line: " << line << std::endl;
         }
     }
-    
-    std::string parseKeyNotes(std::ifstream& file) {
-        std::string line;
-        int currentDensity = 4;
-        std::size_t currentFragment = 0;
-        
-        while (std::getline(file, line)) {
-            line = trim(line);
-            
-            if (!line.empty() && line[0] == '&') {
-                return line;
+
+    static bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+    // Up to 9 digits at p, so the value fits an int
+    static const char* scanDigits(const char* p, const char* end, int& value) {
+        const char* begin = p;
+        value = 0;
+        while (p < end && isDigit(*p) && p - begin < 9)
+            value = value * 10 + (*p++ - '0');
+        return p;
+    }
+
+    // Spaces within a line
+    static bool isBlank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+    // ',', '/' or '\n', whatever ends a note
+    static bool isNoteEnd(char c) {
+        return c == ',' || c == '/' || c == '\n';
+    }
+
+    // Notes are placed on a grid of `density` cells per 4 beats, one cell
+    // per comma-separated field, notes in a cell separated by '/'. Reads the
+    // note lines from p in one forward scan and returns the first line that
+    // is not one (or end): well-formed notes ("<lane>", "<lane>h[<grids>]",
+    // "G<lane>") are decoded on the way, anything else is cut out and handed
+    // to the per-note parsers, which also report the errors. One instance per
+    // section keeps the section test out of the per-note path.
+    template <Section section>
+    const char* parseNoteLine(const char* p, const char* end, int density,
+                              std::size_t& currentFragment) {
+        std::size_t fragmentsPerGrid = (fragmentsPerBeat * 4) / density;
+        // Kept in a local: every note store may alias a reference
+        std::size_t fragment = currentFragment;
+        // One-digit holds fit a note without the cut and its warning
+        bool shortHolds = fragmentsPerGrid * 9 <= KeyNoteData::MAX_HOLD;
+
+        // Every ',' closes a cell; the last cell counts only if something
+        // but blanks follows the last ',', like std::getline on ','
+        bool cellOpen = true;
+        for (;;) {
+            if (p == end || *p == '\n') {
+                if (cellOpen) fragment += fragmentsPerGrid;
+                // The note lines after this one are read in the same call
+                while (p < end && isSpace(*p)) ++p;
+                if (p == end || *p == '&' || *p == '#' || *p == '{') {
+                    currentFragment = fragment;
+                    return p;
+                }
+                cellOpen = true;
+                continue;
             }
-            
-            if (line.empty() || line[0] == '#') continue;
-            
-            if (line[0] == '{' && line.back() == '}') {
-                currentDensity = std::stoi(line.substr(1, line.length() - 2));
+            char c = *p;
+
+            // Most key notes are a single-digit tap or a hold of a few grids
+            // right before the separator. A ',' or '/' after one is taken in
+            // the same step, without a branch
+            if (section == Section::KEYNOTES &&
+                static_cast<unsigned char>(c - '1') < 9 && end - p >= 2) {
+                std::size_t lane = static_cast<std::size_t>(c - '1');
+                const char* sep = p + 1;
+                int hold = -1;
+                if (shortHolds && end - p >= 6 && p[1] == 'h' && p[2] == '[' &&
+                    isDigit(p[3]) && p[4] == ']') {
+                    hold = (p[3] - '0') * static_cast<int>(fragmentsPerGrid);
+                    sep = p + 5;
+                }
+                if (isNoteEnd(*sep)) {
+                    keyNotes.push_back({fragment, lane, hold});
+                    bool comma = *sep == ',';
+                    fragment += comma ? fragmentsPerGrid : 0;
+                    cellOpen = !comma;
+                    p = sep + (*sep != '\n');
+                    continue;
+                }
+            }
+            if (section == Section::MOUSENOTES && (c == 'G' || c == 'R') &&
+                end - p >= 3 && static_cast<unsigned char>(p[1] - '1') < 4) {
+                const char* sep = p + 2;
+                if (isNoteEnd(*sep)) {
+                    mouseNotes.push_back({fragment,
+                                          static_cast<std::size_t>(p[1] - '1'),
+                                          c == 'G' ? 0 : 1});
+                    bool comma = *sep == ',';
+                    fragment += comma ? fragmentsPerGrid : 0;
+                    cellOpen = !comma;
+                    p = sep + (*sep != '\n');
+                    continue;
+                }
+            }
+
+            if (c == ',') {
+                fragment += fragmentsPerGrid;
+                cellOpen = false;
+                ++p;
                 continue;
             }
-            
-            parseKeyNoteLine(line, currentDensity, currentFragment);
-        }
-        return "";
-    }
-    
-    void parseKeyNoteLine(const std::string& line, int density, std::size_t& currentFragment) {
-        std::size_t fragmentsPerGrid = (fragmentsPerBeat * 4) / density;
-        std::stringstream ss(line);
-        std::string token;
-        
-        while (std::getline(ss, token, ',')) {
-            token = trim(token);
-            if (!token.empty()) {
-                parseKeyNoteToken(token, currentFragment, fragmentsPerGrid);
+            if (isBlank(c)) {
+                ++p;
+                continue;
             }
-            currentFragment += fragmentsPerGrid;
-        }
-    }
-    
-    void parseKeyNoteToken(const std::string& token, std::size_t fragment, std::size_t fragmentsPerGrid) {
-        if (token.find('/') != std::string::npos) {
-            std::stringstream ss(token);
-            std::string noteStr;
-            while (std::getline(ss, noteStr, '/')) {
-                parseSingleKeyNote(noteStr, fragment, fragmentsPerGrid);
+            cellOpen = true;
+            if (c == '/') {
+                ++p;
+                continue;
             }
-        } else {
-            parseSingleKeyNote(token, fragment, fragmentsPerGrid);
-        }
-    }
-    
-    void parseSingleKeyNote(const std::string& noteStr, std::size_t fragment, std::size_t fragmentsPerGrid) {
-        if (noteStr.find("h[") != std::string::npos) {
-            size_t hPos = noteStr.find('h');
-            size_t bracketStart = noteStr.find('[');
-            size_t bracketEnd = noteStr.find(']');
-            
-            int lane = std::stoi(noteStr.substr(0, hPos)) - 1;
-            int grids = std::stoi(noteStr.substr(bracketStart + 1, bracketEnd - bracketStart - 1));
-            int8_t holdFragments = static_cast<int8_t>(grids * fragmentsPerGrid);
-            
-            keyNotes.push_back({fragment, static_cast<std::size_t>(lane), holdFragments});
-        } else {
-            int lane = std::stoi(noteStr) - 1;
-            keyNotes.push_back({fragment, static_cast<std::size_t>(lane), -1});
-        }
-    }
-    
-    std::string parseMouseNotes(std::ifstream& file) {
-        std::string line;
-        int currentDensity = 4;
-        std::size_t currentFragment = 0;
-        
-        while (std::getline(file, line)) {
-            line = trim(line);
-            
-            if (!line.empty() && line[0] == '&') {
-                return line;
+
+            const char* noteBegin = p;
+            int lane, grids = -1;
+            const char* q;
+            bool fast;
+            if (section == Section::KEYNOTES) {
+                q = scanDigits(p, end, lane);
+                fast = q != p && lane > 0;
+                if (fast && end - q >= 2 && q[0] == 'h' && q[1] == '[') {
+                    const char* h = q + 2;
+                    q = scanDigits(h, end, grids);
+                    fast = q != h;
+                    if (q < end && *q == ']') ++q;
+                }
+            } else {
+                q = p + 1;
+                fast = c == 'G' || c == 'R';
+                if (fast) {
+                    q = scanDigits(q, end, lane);
+                    fast = q != p + 1 && lane >= 1 && lane <= 4;
+                }
             }
-            
-            if (line.empty() || line[0] == '#') continue;
-            
-            if (line[0] == '{' && line.back() == '}') {
-                currentDensity = std::stoi(line.substr(1, line.length() - 2));
+            const char* after = q;
+            while (after < end && isBlank(*after)) ++after;
+            if (fast && (after == end || *after == ',' || *after == '/' ||
+                         *after == '\n')) {
+                if (section == Section::KEYNOTES) {
+                    long long hold = grids < 0 ? -1
+                        : static_cast<long long>(grids) *
+                          static_cast<long long>(fragmentsPerGrid);
+                    addKeyNote(std::string_view(noteBegin, q - noteBegin),
+                               fragment, lane - 1, hold);
+                } else {
+                    mouseNotes.push_back({fragment,
+                                          static_cast<std::size_t>(lane - 1),
+                                          c == 'G' ? 0 : 1});
+                }
+                p = after;
                 continue;
             }
-            
-            parseMouseNoteLine(line, currentDensity, currentFragment);
+
+            while (p < end && *p != ',' && *p != '/' && *p != '\n') ++p;
+            std::string_view note = trim(std::string_view(noteBegin, p - noteBegin));
+            if (section == Section::KEYNOTES)
+                parseSingleKeyNote(note, fragment, fragmentsPerGrid);
+            else
+                parseSingleMouseObject(note, fragment);
         }
-        return "";
     }
-    
-    void parseMouseNoteLine(const std::string& line, int density, std::size_t& currentFragment) {
-        std::size_t fragmentsPerGrid = (fragmentsPerBeat * 4) / density;
-        std::stringstream ss(line);
-        std::string token;
-        
-        while (std::getline(ss, token, ',')) {
-            token = trim(token);
-            if (!token.empty()) {
-                parseMouseNoteToken(token, currentFragment);
-            }
-            currentFragment += fragmentsPerGrid;
+
+    const char* parseNoteLine(const char* p, const char* end, Section section,
+                              int density, std::size_t& currentFragment) {
+        if (section == Section::KEYNOTES)
+            return parseNoteLine<Section::KEYNOTES>(p, end, density, currentFragment);
+        return parseNoteLine<Section::MOUSENOTES>(p, end, density, currentFragment);
+    }
+
+    // holdFragments < 0 for a tap; longer holds than a note can store are cut
+    void addKeyNote(std::string_view noteStr, std::size_t fragment, int lane,
+                    long long holdFragments) {
+        if (holdFragments > static_cast<long long>(KeyNoteData::MAX_HOLD)) {
+            std::cerr << "[WARNING] Hold too long, cut to "
+                      << KeyNoteData::MAX_HOLD << " fragments: " << noteStr
+                      << " at fragment " << fragment << std::endl;
+            holdFragments = KeyNoteData::MAX_HOLD;
         }
+        keyNotes.push_back({fragment, static_cast<std::size_t>(lane),
+                            static_cast<int>(holdFragments)});
     }
-    
-    // 修正版：支援和弦 (G1/R2 表示同時出現綠色1和紅色2)
-    void parseMouseNoteToken(const std::string& token, std::size_t fragment) {
-        // 檢查是否為和弦
-        if (token.find('/') != std::string::npos) {
-            std::stringstream ss(token);
-            std::string singleNoteStr;
-            
-            // 逐一解析和弦中的每個物件
-            while (std::getline(ss, singleNoteStr, '/')) {
-                singleNoteStr = trim(singleNoteStr);  // 移除空白
-                if (!singleNoteStr.empty()) {
-                    parseSingleMouseObject(singleNoteStr, fragment);
-                }
+
+    void parseSingleKeyNote(std::string_view noteStr, std::size_t fragment, std::size_t fragmentsPerGrid) {
+        int lane;
+        if (!parseInt(noteStr, lane) || lane < 1) {
+            std::cerr << "[WARNING] Invalid Key Note: " << noteStr
+                      << " at fragment " << fragment << std::endl;
+            return;
+        }
+        --lane;
+
+        std::size_t hPos = noteStr.find("h[");
+        if (hPos != std::string_view::npos) {
+            int grids;
+            if (!parseInt(noteStr.substr(hPos + 2), grids)) {
+                std::cerr << "[WARNING] Invalid hold length: " << noteStr
+                          << " at fragment " << fragment << std::endl;
+                return;
             }
+            long long holdFragments =
+                static_cast<long long>(grids) *
+                static_cast<long long>(fragmentsPerGrid);
+            addKeyNote(noteStr, fragment, lane,
+                       holdFragments > 0 ? holdFragments : 0);
         } else {
-            // 單一物件
-            parseSingleMouseObject(token, fragment);
+            addKeyNote(noteStr, fragment, lane, -1);
         }
     }
-    
-    // 新增：解析單一 Mouse Object
-    void parseSingleMouseObject(const std::string& noteStr, std::size_t fragment) {
-        if (noteStr.length() >= 2) {
-            char type = noteStr[0];
-            
-            if (type == 'G' || type == 'R') {
-                try {
-                    int lane = std::stoi(noteStr.substr(1)) - 1;  // 1-4 轉成 0-3
-                    int noteType = (type == 'G') ? 0 : 1;
-                    
-                    if (lane >= 0 && lane < 4) {  // 假設 LANES = 4
-                        mouseNotes.push_back({fragment, static_cast<std::size_t>(lane), noteType});
-                    } else {
-                        std::cerr << "[WARNING] Mouse Note lane out of bounds: " << (lane + 1) 
-                                  << " at fragment " << fragment << std::endl;
-                    }
-                } catch (const std::invalid_argument& e) {
-                    std::cerr << "[WARNING] Invalid Mouse Note format: " << noteStr 
-                              << " at fragment " << fragment << std::endl;
-                } catch (const std::out_of_range& e) {
-                    std::cerr << "[WARNING] Mouse Note lane number too large: " << noteStr 
-                              << " at fragment " << fragment << std::endl;
-                }
-            }
+
+    // G1/R2 表示同時出現綠色1和紅色2
+    void parseSingleMouseObject(std::string_view noteStr, std::size_t fragment) {
+        if (noteStr.length() < 2) return;
+        char type = noteStr[0];
+        if (type != 'G' && type != 'R') return;
+
+        int lane;
+        if (!parseInt(noteStr.substr(1), lane)) {
+            std::cerr << "[WARNING] Invalid Mouse Note format: " << noteStr
+                      << " at fragment " << fragment << std::endl;
+            return;
+        }
+        --lane;  // 1-4 轉成 0-3
+        int noteType = (type == 'G') ? 0 : 1;
+
+        if (lane >= 0 && lane < 4) {  // 假設 LANES = 4
+            mouseNotes.push_back({fragment, static_cast<std::size_t>(lane), noteType});
+        } else {
+            std::cerr << "[WARNING] Mouse Note lane out of bounds: " << (lane + 1)
+                      << " at fragment " << fragment << std::endl;
         }
     }
 
 public:
-    ChartParser(mystd::vector<KeyNoteData>& keyNotes_) 
-        : bpm(120), offset(0), fragmentsPerBeat(4), keyNotes(keyNotes_) {}
-    
+    ChartParser(mystd::vector<KeyNoteData>& keyNotes_)
+        : bpm(120), offset(0), fragmentsPerBeat(4), keyNotes(keyNotes_),
+          timing(60000.0 / bpm / fragmentsPerBeat) {}
+
     bool load(const std::string& filepath) {
-        std::ifstream file(filepath);
+        std::ifstream file(filepath, std::ios::binary | std::ios::ate);
         if (!file.is_open()) {
             std::cerr << "[ERROR] Cannot open chart: " << filepath << std::endl;
             return false;
         }
-        
-        std::string line;
-        std::string nextLine = "";
-        
-        while (true) {
-            if (!nextLine.empty()) {
-                line = nextLine;
-                nextLine = "";
-            } else {
-                if (!std::getline(file, line)) break;
-            }
-            
-            line = trim(line);
-            
-            if (line.empty() || line[0] == '#') continue;
-            
-            if (line.find("&bpm=") == 0 || line.find("&offset=") == 0 || 
-                line.find("&music=") == 0 || line.find("&fragments=") == 0) {
-                parseMetadata(line);
-            } else if (line == "&keynotes=") {
-                nextLine = parseKeyNotes(file);
-            } else if (line == "&mousenotes=") {
-                nextLine = parseMouseNotes(file);
-            }
+
+        std::streamsize size = file.tellg();
+        file.seekg(0);
+        buffer.resize(size > 0 ? static_cast<std::size_t>(size) : 0);
+        if (size > 0 && !file.read(buffer.data(), size)) {
+            std::cerr << "[ERROR] Cannot read chart: " << filepath << std::endl;
+            return false;
         }
-        
         file.close();
-        
-        qsort(keyNotes.begin(), keyNotes.end(), 
-            [](const KeyNoteData& a, const KeyNoteData& b) { 
-                return a.startFragment < b.startFragment; 
-            });
-        qsort(mouseNotes.begin(), mouseNotes.end(),
-            [](const MouseNoteData& a, const MouseNoteData& b) { 
-                return a.startFragment < b.startFragment; 
-            });
-        
+
+        parse(buffer);
+
         std::cout << "[OK] Chart loaded: " << filepath << std::endl;
         std::cout << "      BPM=" << bpm << ", Fragments/Beat=" << fragmentsPerBeat << std::endl;
         std::cout << "      Key notes=" << keyNotes.size() << ", Mouse notes=" << mouseNotes.size() << std::endl;
-        
+
         return true;
     }
-    
+
+    // Parses chart text already in memory, replacing the current notes and
+    // metadata; lines the chart leaves out get the constructor's defaults
+    void parse(std::string_view text) {
+        bpm = 120;
+        offset = 0;
+        fragmentsPerBeat = 4;
+        musicFile.clear();
+        keyNotes.clear();
+        mouseNotes.clear();
+        timingLines.clear();
+        // Charts average a few bytes per note, so a big chart's notes mostly
+        // fit without regrowing the vector
+        keyNotes.reserve(text.size() / 4);
+
+        Section section = Section::NONE;
+        int currentDensity = 4;
+        std::size_t currentFragment = 0;
+        const char* p = text.data();
+        const char* end = p + text.size();
+
+        while (p < end) {
+            while (p < end && isSpace(*p)) ++p; // also skips blank lines
+            if (p == end) break;
+
+            // Note lines, by far the most, are parsed straight from the buffer
+            if (section != Section::NONE && *p != '&' && *p != '#' && *p != '{') {
+                p = parseNoteLine(p, end, section, currentDensity, currentFragment);
+                continue;
+            }
+
+            const char* eol = std::find(p, end, '\n');
+            std::string_view line = trim(std::string_view(p, eol - p));
+            p = eol;
+            if (line[0] == '#') continue;
+
+            // Any '&' line ends a note block
+            if (line[0] == '&') {
+                section = Section::NONE;
+                if (line == "&keynotes=" || line == "&mousenotes=") {
+                    section = line == "&keynotes=" ? Section::KEYNOTES : Section::MOUSENOTES;
+                    currentDensity = 4;
+                    currentFragment = 0;
+                } else {
+                    parseMetadata(line);
+                }
+                continue;
+            }
+            if (section == Section::NONE) continue;
+
+            if (line[0] == '{' && line.back() == '}') {
+                int density;
+                if (parseInt(line.substr(1, line.length() - 2), density) && density > 0)
+                    currentDensity = density;
+                else
+                    std::cerr << "[WARNING] Invalid density: " << line << std::endl;
+                continue;
+            }
+
+            // A '{' line that is not a density
+            parseNoteLine(line.data(), line.data() + line.size(), section,
+                          currentDensity, currentFragment);
+        }
+
+        mystd::vector<TimingEvent> events;
+        for (const TimingLine& t : timingLines) {
+            double fragment = std::round(t.beat * fragmentsPerBeat);
+            events.push_back({static_cast<uint32_t>(fragment), t.stop, t.value});
+        }
+        timing = TimingMap::build(bpm, fragmentsPerBeat, events);
+
+        // Blocks are written in time order, so the notes are usually sorted
+        // already and only get the linear check
+        auto byKeyStart = [](const KeyNoteData& a, const KeyNoteData& b) {
+            return a.startFragment < b.startFragment;
+        };
+        if (!std::is_sorted(keyNotes.begin(), keyNotes.end(), byKeyStart))
+            mystd::sort(keyNotes.begin(), keyNotes.end(), byKeyStart);
+        auto byMouseStart = [](const MouseNoteData& a, const MouseNoteData& b) {
+            return a.startFragment < b.startFragment;
+        };
+        if (!std::is_sorted(mouseNotes.begin(), mouseNotes.end(), byMouseStart))
+            mystd::sort(mouseNotes.begin(), mouseNotes.end(), byMouseStart);
+    }
+
     const std::vector<MouseNoteData>& getMouseNotes() const { return mouseNotes; }
     const std::string& getMusicFile() const { return musicFile; }
     int getBPM() const { return bpm; }
     int getOffset() const { return offset; }
     int getFragmentsPerBeat() const { return fragmentsPerBeat; }
-    
+    // Starts at &bpm=, then follows &bpmchange= and &stop=
+    const TimingMap& getTimingMap() const { return timing; }
+
     double getFragmentTime(std::size_t fragment) const {
-        double beatDuration = 60000.0 / bpm;
-        double fragmentDuration = beatDuration / fragmentsPerBeat;
-        return offset + fragment * fragmentDuration;
+        return offset + timing.timeOf(fragment);
     }
-    
+
     void printChart() const {
         std::cout << "\n=== Chart Information ===" << std::endl;
         std::cout << "BPM: " << bpm << ", Offset: " << offset << " ms" << std::endl;
         std::cout << "Fragments per beat: " << fragmentsPerBeat << std::endl;
         std::cout << "Music file: " << musicFile << std::endl;
-        
+
         std::cout << "\n=== Key Notes (" << keyNotes.size() << ") ===" << std::endl;
         if (!keyNotes.empty()) {
             std::cout << "Fragment\tLane\tHolds\tTime(ms)" << std::endl;
             for (size_t i = 0; i < std::min(size_t(5), keyNotes.size()); i++) {
                 const auto& n = keyNotes[i];
-                std::cout << n.startFragment << "\t\t" << n.lane << "\t";
-                if (n.holds == -1) {
+                std::cout << n.startFragment << "\t\t" << (int)n.lane << "\t";
+                if (n.isTap()) {
                     std::cout << "TAP";
                 } else {
                     std::cout << (int)n.holds;
@@ -290,14 +471,14 @@ public:
                 std::cout << "... (showing first 5 of " << keyNotes.size() << ")" << std::endl;
             }
         }
-        
+
         std::cout << "\n=== Mouse Notes (" << mouseNotes.size() << ") ===" << std::endl;
         if (!mouseNotes.empty()) {
             std::cout << "Fragment\tLane\tType\tTime(ms)" << std::endl;
             for (size_t i = 0; i < std::min(size_t(5), mouseNotes.size()); i++) {
                 const auto& m = mouseNotes[i];
-                std::cout << m.startFragment << "\t\t" << m.lane << "\t" 
-                          << (m.type == 0 ? "GREEN" : "RED") << "\t" 
+                std::cout << m.startFragment << "\t\t" << m.lane << "\t"
+                          << (m.type == 0 ? "GREEN" : "RED") << "\t"
                           << getFragmentTime(m.startFragment) << std::endl;
             }
             if (mouseNotes.size() > 5) {
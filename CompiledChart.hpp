@@ -0,0 +1,347 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "include/span.hpp"
+#include "include/vector.hpp"
+
+#include "ChartParser.hpp"
+#include "KeyNoteData.hpp"
+#include "TimingMap.hpp"
+
+// Read-only memory mapping of a whole file
+class MappedFile {
+private:
+  const char *ptr = nullptr;
+  std::size_t length = 0;
+#ifdef _WIN32
+  HANDLE mapping = nullptr;
+#endif
+
+public:
+  MappedFile() = default;
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+  ~MappedFile() { close(); }
+
+  bool open(const std::string &path) {
+    close();
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                              nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                              nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+      return false;
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+      CloseHandle(file);
+      return false;
+    }
+    mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file); // the mapping keeps the file open
+    if (!mapping)
+      return false;
+    ptr = static_cast<const char *>(
+        MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (!ptr) {
+      CloseHandle(mapping);
+      mapping = nullptr;
+      return false;
+    }
+    length = static_cast<std::size_t>(size.QuadPart);
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+      return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+      ::close(fd);
+      return false;
+    }
+    void *map = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // the mapping keeps the file open
+    if (map == MAP_FAILED)
+      return false;
+    ptr = static_cast<const char *>(map);
+    length = static_cast<std::size_t>(st.st_size);
+#endif
+    return true;
+  }
+
+  void close() {
+    if (!ptr)
+      return;
+#ifdef _WIN32
+    UnmapViewOfFile(ptr);
+    CloseHandle(mapping);
+    mapping = nullptr;
+#else
+    munmap(const_cast<char *>(ptr), length);
+#endif
+    ptr = nullptr;
+    length = 0;
+  }
+
+  const char *data() const { return ptr; }
+  std::size_t size() const { return length; }
+  std::string_view view() const { return {ptr, length}; }
+};
+
+constexpr uint32_t COMPILED_CHART_VERSION = 3; // 3: 8-byte key notes
+constexpr char COMPILED_CHART_MAGIC[8] = {'R', 'Q', 'C', 'H', 'A', 'R', 'T', 0};
+
+// File layout: this header, then the key notes, the mouse notes, the timing
+// sections and the music path, each at the offset given. Records are stored
+// exactly as in memory, so their sizes are recorded and a cache written by
+// a different build is simply rebuilt.
+struct CompiledChartHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t headerSize;
+  uint32_t keyNoteSize;
+  uint32_t mouseNoteSize;
+  uint32_t timingSectionSize;
+  uint32_t reserved;
+  uint64_t sourceHash; // FNV-1a of the chart text
+  uint64_t sourceSize;
+  uint64_t fileSize;
+  int32_t bpm;
+  int32_t offset;
+  int32_t fragmentsPerBeat;
+  uint32_t musicLength;
+  uint64_t keyOffset, keyCount;     // sorted by startFragment
+  uint64_t mouseOffset, mouseCount; // sorted by startFragment
+  uint64_t timingOffset, timingCount;
+  uint64_t musicOffset;
+};
+
+// Written to a temporary name first, so a crash never leaves a torn file
+// under the final name. Creates missing parent directories.
+inline bool writeFileAtomically(const std::string &path,
+                                std::string_view data) {
+  std::error_code ec;
+  std::filesystem::create_directories(
+      std::filesystem::path(path).parent_path(), ec);
+  std::string temp = path + ".tmp";
+  {
+    std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+    if (!out.write(data.data(), data.size()))
+      return false;
+  }
+  std::filesystem::rename(temp, path, ec);
+  if (ec) {
+    std::filesystem::remove(temp, ec);
+    return false;
+  }
+  return true;
+}
+
+inline uint64_t hashChartText(std::string_view text) {
+  uint64_t hash = 14695981039346656037ull;
+  for (unsigned char c : text) {
+    hash ^= c;
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+// A chart compiled once into the binary format above and cached as
+// <cacheDir>/<hash of the text>.rqc. Later loads of the same text map the
+// cached file and use the notes in place: no parsing, no sorting.
+class CompiledChart {
+private:
+  MappedFile source;
+  MappedFile cached;
+  std::string built; // compiled image when the cache could not be used
+
+  int bpm = 120;
+  int offset = 0;
+  int fragmentsPerBeat = 4;
+  std::string musicFile;
+  mystd::span<const KeyNoteData> keyNotes;
+  mystd::span<const MouseNoteData> mouseNotes;
+  TimingMap timing{60000.0 / 120 / 4};
+
+  static constexpr std::size_t ALIGN = 16;
+
+  static std::size_t alignUp(std::size_t n) {
+    return (n + ALIGN - 1) / ALIGN * ALIGN;
+  }
+
+  static bool inBounds(uint64_t offset, uint64_t bytes, uint64_t fileSize) {
+    return offset <= fileSize && bytes <= fileSize - offset;
+  }
+
+  // Checks everything use() relies on
+  static bool valid(std::string_view image, uint64_t hash, uint64_t size) {
+    if (image.size() < sizeof(CompiledChartHeader))
+      return false;
+    CompiledChartHeader h;
+    std::memcpy(&h, image.data(), sizeof h);
+    return std::memcmp(h.magic, COMPILED_CHART_MAGIC, 8) == 0 &&
+           h.version == COMPILED_CHART_VERSION &&
+           h.headerSize == sizeof(CompiledChartHeader) &&
+           h.keyNoteSize == sizeof(KeyNoteData) &&
+           h.mouseNoteSize == sizeof(MouseNoteData) &&
+           h.timingSectionSize == sizeof(TimingSection) &&
+           h.sourceHash == hash && h.sourceSize == size &&
+           h.fileSize == image.size() && h.fragmentsPerBeat > 0 &&
+           h.bpm > 0 && h.keyOffset % ALIGN == 0 &&
+           h.mouseOffset % ALIGN == 0 && h.timingOffset % ALIGN == 0 &&
+           h.keyCount <= image.size() / sizeof(KeyNoteData) &&
+           h.mouseCount <= image.size() / sizeof(MouseNoteData) &&
+           h.timingCount <= image.size() / sizeof(TimingSection) &&
+           inBounds(h.keyOffset, h.keyCount * sizeof(KeyNoteData),
+                    image.size()) &&
+           inBounds(h.mouseOffset, h.mouseCount * sizeof(MouseNoteData),
+                    image.size()) &&
+           inBounds(h.timingOffset, h.timingCount * sizeof(TimingSection),
+                    image.size()) &&
+           inBounds(h.musicOffset, h.musicLength, image.size());
+  }
+
+  void use(std::string_view image) {
+    const CompiledChartHeader *h =
+        reinterpret_cast<const CompiledChartHeader *>(image.data());
+    bpm = h->bpm;
+    offset = h->offset;
+    fragmentsPerBeat = h->fragmentsPerBeat;
+    musicFile.assign(image.data() + h->musicOffset, h->musicLength);
+    keyNotes = {reinterpret_cast<const KeyNoteData *>(image.data() +
+                                                      h->keyOffset),
+                static_cast<std::size_t>(h->keyCount)};
+    mouseNotes = {reinterpret_cast<const MouseNoteData *>(image.data() +
+                                                          h->mouseOffset),
+                  static_cast<std::size_t>(h->mouseCount)};
+    timing = TimingMap(mystd::span<const TimingSection>(
+        reinterpret_cast<const TimingSection *>(image.data() +
+                                                h->timingOffset),
+        static_cast<std::size_t>(h->timingCount)));
+  }
+
+  static std::string compile(std::string_view text, uint64_t hash) {
+    mystd::vector<KeyNoteData> keys;
+    ChartParser parser(keys);
+    parser.parse(text);
+    const std::vector<MouseNoteData> &mouse = parser.getMouseNotes();
+    const std::string &music = parser.getMusicFile();
+    mystd::span<const TimingSection> sections =
+        parser.getTimingMap().getSections();
+
+    CompiledChartHeader h = {};
+    std::memcpy(h.magic, COMPILED_CHART_MAGIC, 8);
+    h.version = COMPILED_CHART_VERSION;
+    h.headerSize = sizeof(CompiledChartHeader);
+    h.keyNoteSize = sizeof(KeyNoteData);
+    h.mouseNoteSize = sizeof(MouseNoteData);
+    h.timingSectionSize = sizeof(TimingSection);
+    h.sourceHash = hash;
+    h.sourceSize = text.size();
+    h.bpm = parser.getBPM();
+    h.offset = parser.getOffset();
+    h.fragmentsPerBeat = parser.getFragmentsPerBeat();
+    h.keyOffset = alignUp(sizeof h);
+    h.keyCount = keys.size();
+    h.mouseOffset = alignUp(h.keyOffset + keys.size() * sizeof(KeyNoteData));
+    h.mouseCount = mouse.size();
+    h.timingOffset =
+        alignUp(h.mouseOffset + mouse.size() * sizeof(MouseNoteData));
+    h.timingCount = sections.size();
+    h.musicOffset = h.timingOffset + sections.size() * sizeof(TimingSection);
+    h.musicLength = static_cast<uint32_t>(music.size());
+    h.fileSize = h.musicOffset + music.size();
+
+    std::string image(h.fileSize, '\0');
+    std::memcpy(image.data(), &h, sizeof h);
+    if (!keys.empty())
+      std::memcpy(image.data() + h.keyOffset, keys.data(),
+                  keys.size() * sizeof(KeyNoteData));
+    if (!mouse.empty())
+      std::memcpy(image.data() + h.mouseOffset, mouse.data(),
+                  mouse.size() * sizeof(MouseNoteData));
+    std::memcpy(image.data() + h.timingOffset, sections.data(),
+                sections.size() * sizeof(TimingSection));
+    std::memcpy(image.data() + h.musicOffset, music.data(), music.size());
+    return image;
+  }
+
+public:
+  static std::string cachePath(const std::string &cacheDir, uint64_t hash) {
+    char name[24];
+    std::snprintf(name, sizeof name, "%016llx.rqc",
+                  static_cast<unsigned long long>(hash));
+    return cacheDir + "/" + name;
+  }
+
+  // Spans from earlier loads are invalidated
+  bool load(const std::string &chartPath,
+            const std::string &cacheDir = "./chart/.cache") {
+    if (!source.open(chartPath)) {
+      std::cerr << "[ERROR] Cannot open chart: " << chartPath << std::endl;
+      return false;
+    }
+    uint64_t hash = hashChartText(source.view());
+    uint64_t size = source.size();
+    std::string path = cachePath(cacheDir, hash);
+
+    built.clear();
+    bool fromCache = cached.open(path) && valid(cached.view(), hash, size);
+    if (fromCache) {
+      use(cached.view());
+    } else {
+      cached.close();
+      built = compile(source.view(), hash);
+      if (writeFileAtomically(path, built) && cached.open(path) &&
+          valid(cached.view(), hash, size)) {
+        built.clear();
+        built.shrink_to_fit();
+        use(cached.view());
+      } else {
+        std::cerr << "[WARNING] Cannot write chart cache: " << path
+                  << std::endl;
+        use(built);
+      }
+    }
+    source.close();
+
+    std::cout << "[OK] Chart loaded: " << chartPath
+              << (fromCache ? " (cached)" : " (compiled)") << std::endl;
+    std::cout << "      BPM=" << bpm << ", Fragments/Beat=" << fragmentsPerBeat
+              << std::endl;
+    std::cout << "      Key notes=" << keyNotes.size()
+              << ", Mouse notes=" << mouseNotes.size() << std::endl;
+    return true;
+  }
+
+  mystd::span<const KeyNoteData> getKeyNotes() const { return keyNotes; }
+  mystd::span<const MouseNoteData> getMouseNotes() const {
+    return mouseNotes;
+  }
+  const std::string &getMusicFile() const { return musicFile; }
+  const TimingMap &getTimingMap() const { return timing; }
+  int getBPM() const { return bpm; }
+  int getOffset() const { return offset; }
+  int getFragmentsPerBeat() const { return fragmentsPerBeat; }
+};
@@ -0,0 +1,217 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+
+#include "include/array.hpp"
+#include "include/vector.hpp"
+
+struct FrameSample {
+  float frameMs;    // start of one main-loop iteration to the next
+  float simulateMs; // last simulation tick, taken from the view drawn
+  float renderMs;
+  float presentMs;
+};
+
+enum FramePhase { PHASE_FRAME, PHASE_SIMULATE, PHASE_RENDER, PHASE_PRESENT };
+constexpr std::size_t FRAME_PHASES = 4;
+constexpr const char *FRAME_PHASE_NAMES[FRAME_PHASES] = {"frame", "simulate",
+                                                         "render", "present"};
+
+inline float phaseMs(const FrameSample &f, FramePhase phase) {
+  switch (phase) {
+  case PHASE_SIMULATE:
+    return f.simulateMs;
+  case PHASE_RENDER:
+    return f.renderMs;
+  case PHASE_PRESENT:
+    return f.presentMs;
+  default:
+    return f.frameMs;
+  }
+}
+
+// Counts of times in BIN_MS buckets, the last bucket also taking anything
+// longer
+struct PacingHistogram {
+  static constexpr float BIN_MS = 0.25f;
+  static constexpr std::size_t BINS = 256; // last bin also takes >= 64 ms
+
+  mystd::array<uint32_t, BINS> counts{};
+  std::size_t total = 0;
+
+  static std::size_t binOf(float ms) {
+    std::size_t bin = static_cast<std::size_t>(ms / BIN_MS);
+    return bin < BINS ? bin : BINS - 1;
+  }
+
+  void add(float ms) {
+    ++counts[binOf(ms)];
+    ++total;
+  }
+  void remove(float ms) {
+    --counts[binOf(ms)];
+    --total;
+  }
+  void clear() {
+    counts.fill(0);
+    total = 0;
+  }
+
+  // Time (upper bin edge) that only `fraction` of the samples exceed
+  float percentileMs(float fraction) const {
+    std::size_t allowed = static_cast<std::size_t>(total * fraction);
+    std::size_t seen = 0;
+    for (std::size_t bin = BINS; bin-- > 0;) {
+      seen += counts[bin];
+      if (seen > allowed)
+        return (bin + 1) * BIN_MS;
+    }
+    return 0;
+  }
+};
+
+// Frame-pacing recorder on SDL_GetPerformanceCounter. Keeps every frame of
+// the current song for the CSV, plus a rolling window of the last HISTORY
+// frames with one histogram per phase for the on-screen graph and lows.
+class FramePacer {
+public:
+  static constexpr std::size_t HISTORY = 1024;
+
+private:
+  double msPerTick = 1000.0 / SDL_GetPerformanceFrequency();
+  uint64_t frameStart = 0;
+  uint64_t lapStart = 0;
+  FrameSample current = {};
+
+  mystd::vector<FrameSample> frames;
+  mystd::array<FrameSample, HISTORY> recent{};
+  std::size_t recentCount = 0;
+  std::size_t recentHead = 0; // next slot to write
+  mystd::array<PacingHistogram, FRAME_PHASES> histograms{};
+  double recentSum = 0; // frame times only
+
+  float elapsed(uint64_t since, uint64_t now) const {
+    return static_cast<float>((now - since) * msPerTick);
+  }
+
+public:
+  void reset() {
+    frames.clear();
+    recent.fill({});
+    for (PacingHistogram &h : histograms)
+      h.clear();
+    recentCount = recentHead = 0;
+    recentSum = 0;
+    frameStart = 0;
+  }
+
+  // Call at the top of every recorded main-loop iteration
+  void beginFrame() {
+    uint64_t now = SDL_GetPerformanceCounter();
+    frameStart = now;
+    lapStart = now;
+    current = {};
+  }
+
+  // startLap() before rendering / presenting, endRender() / endPresent()
+  // after
+  void startLap() { lapStart = SDL_GetPerformanceCounter(); }
+  void endRender() {
+    current.renderMs += elapsed(lapStart, SDL_GetPerformanceCounter());
+  }
+  void endPresent() {
+    current.presentMs += elapsed(lapStart, SDL_GetPerformanceCounter());
+  }
+  void setSimulate(float ms) { current.simulateMs = ms; }
+
+  // Records the frame begun by the last beginFrame()
+  void endFrame() {
+    if (frameStart == 0)
+      return;
+    current.frameMs = elapsed(frameStart, SDL_GetPerformanceCounter());
+    frames.push_back(current);
+
+    if (recentCount == HISTORY) {
+      const FrameSample &old = recent[recentHead];
+      for (std::size_t p = 0; p < FRAME_PHASES; ++p)
+        histograms[p].remove(phaseMs(old, FramePhase(p)));
+      recentSum -= old.frameMs;
+    } else {
+      ++recentCount;
+    }
+    recent[recentHead] = current;
+    for (std::size_t p = 0; p < FRAME_PHASES; ++p)
+      histograms[p].add(phaseMs(current, FramePhase(p)));
+    recentSum += current.frameMs;
+    recentHead = (recentHead + 1) % HISTORY;
+  }
+
+  std::size_t size() const { return recentCount; }
+
+  // i-th most recent frame time, 0 = newest
+  float recentFrame(std::size_t i) const {
+    return recent[(recentHead + HISTORY - 1 - i) % HISTORY].frameMs;
+  }
+
+  float fps() const {
+    return recentSum > 0
+               ? static_cast<float>(recentCount * 1000.0 / recentSum)
+               : 0.0f;
+  }
+
+  // Time of `phase` that only `fraction` of recent frames exceed
+  float percentileMs(float fraction, FramePhase phase = PHASE_FRAME) const {
+    return histograms[phase].percentileMs(fraction);
+  }
+
+  // "1% low" and "0.1% low" as FPS of the 99th / 99.9th percentile frame
+  float lowFps(float fraction) const {
+    float ms = percentileMs(fraction);
+    return ms > 0 ? 1000.0f / ms : 0.0f;
+  }
+
+  // Per-frame times of the whole song
+  bool writeCsv(const char *path) const {
+    std::ofstream out(path);
+    if (!out.is_open()) {
+      std::cerr << "[ERROR] Cannot write frame pacing: " << path << std::endl;
+      return false;
+    }
+    out << "frame,frame_ms,simulate_ms,render_ms,present_ms\n";
+    for (std::size_t i = 0; i < frames.size(); ++i) {
+      const FrameSample &f = frames[i];
+      out << i << ',' << f.frameMs << ',' << f.simulateMs << ','
+          << f.renderMs << ',' << f.presentMs << '\n';
+    }
+    return true;
+  }
+
+  // Percentiles of every phase over the whole song, same buckets as the HUD
+  bool writeSummaryCsv(const char *path) const {
+    std::ofstream out(path);
+    if (!out.is_open()) {
+      std::cerr << "[ERROR] Cannot write frame pacing: " << path << std::endl;
+      return false;
+    }
+    out << "phase,frames,mean_ms,p50_ms,p99_ms,p99.9_ms\n";
+    for (std::size_t p = 0; p < FRAME_PHASES; ++p) {
+      PacingHistogram song;
+      double sum = 0;
+      for (const FrameSample &f : frames) {
+        song.add(phaseMs(f, FramePhase(p)));
+        sum += phaseMs(f, FramePhase(p));
+      }
+      out << FRAME_PHASE_NAMES[p] << ',' << frames.size() << ','
+          << (frames.empty() ? 0.0 : sum / frames.size()) << ','
+          << song.percentileMs(0.5f) << ',' << song.percentileMs(0.01f) << ','
+          << song.percentileMs(0.001f) << '\n';
+    }
+    return true;
+  }
+
+  std::size_t recorded() const { return frames.size(); }
+};
@@ -4,20 +4,15 @@
 #include <cmath>
 #include <cstddef>
 #include <cstdint>
+#include <functional>
 
-#include "include/circulate.hpp"
-#include "include/priority_queue.hpp"
+#include "include/array.hpp"
+#include "include/span.hpp"
 #include "include/vector.hpp"
 
+#include "Highway.hpp"
 #include "KeyNoteData.hpp"
-
-// int8_t: -1 = tap, -2 = invisible tap, >=1 = number of remaining fragments to
-// hold, 0 = empty
-
-template <class T> class game_priority_queue : public mystd::priority_queue<T> {
-public:
-  using mystd::priority_queue<T>::c;
-};
+#include "TimingMap.hpp"
 
 const uint32_t NO_LANE_EFFECT = 0u;
 const uint32_t PERFECT = 1u;
@@ -37,17 +32,58 @@ struct Effect {
   uint32_t num;
 };
 
-bool operator<(Effect lhs, Effect rhs) { return lhs.endTime > rhs.endTime; }
+// Center effects, one slot per kind (like laneEffects has one per lane): a
+// newer effect replaces the live one of the same kind, so insert and expiry
+// are O(1) and at most one COMBO and one SCORE are ever drawn
+class CenterEffects {
+private:
+  mystd::array<Effect, 2> slots{};
+
+  static constexpr std::size_t slotOf(uint32_t content) noexcept {
+    return content == COMBO ? 0 : 1;
+  }
+
+public:
+  inline void push(Effect e) { slots[slotOf(e.content)] = e; }
+
+  inline void clearExpired(uint32_t nowMs) {
+    for (Effect &e : slots)
+      if (e.content != 0 && e.endTime <= nowMs)
+        e = {0, 0, 0};
+  }
+
+  inline void clear() {
+    for (Effect &e : slots)
+      e = {0, 0, 0};
+  }
+
+  std::size_t size() const {
+    std::size_t n = 0;
+    for (const Effect &e : slots)
+      n += e.content != 0;
+    return n;
+  }
+  bool empty() const { return size() == 0; }
+
+  // Iterates every slot; empty slots have content == 0
+  const Effect *begin() const { return slots.begin(); }
+  const Effect *end() const { return slots.end(); }
+};
 
 class Game {
 public:
-  mystd::vector<KeyNoteData>& notes; // sorted by startFragment
+  // Sorted by startFragment; a chart vector or a mapped compiled chart,
+  // owned by the caller and shared
+  mystd::span<const KeyNoteData> notes;
   std::size_t lanes;
   std::size_t fragments;    // visible fragments
-  uint32_t msPerFragment;   // ms per fragment
-  std::size_t loadNext = 0; // next note index to load
+  TimingMap timing;         // fragment <-> ms; every Game has its own
 
-  mystd::vector<mystd::circulate<int8_t, mystd::vector<int8_t>>> highway;
+  // notes[noteIndex[f]] .. notes[noteIndex[f + 1] - 1] start at fragment f
+  mystd::vector<uint32_t> noteIndex;
+  std::size_t longestHold = 0; // in fragments
+
+  Highway highway;
 
   // 1: pressed, 0: not
   mystd::vector<bool> lanePressed;
@@ -55,6 +91,11 @@ public:
   // Hold sustain timing
   mystd::vector<uint32_t> holdPressedTime;
 
+  // Highway cells count a hold down from at most HOLD_CELL_MAX. A longer
+  // hold keeps its top cell at HOLD_CELL_MAX for this many more fragments.
+  static constexpr int8_t HOLD_CELL_MAX = 127;
+  mystd::vector<uint32_t> holdOverflow;
+
   // Scoring, hold not counted for perfect to miss and combo
   uint32_t score = 0, perfectCount = 0, greatCount = 0, goodCount = 0,
            badCount = 0, missCount = 0, combo = 0, maxCombo = 0, heldTime = 0;
@@ -62,26 +103,136 @@ public:
   std::size_t nowFragment = 0;
 
   mystd::vector<Effect> laneEffects;
-  game_priority_queue<Effect> centerEffects = game_priority_queue<Effect>();
-
-  Game(std::size_t lanes_, std::size_t fragments_, uint32_t mpf, mystd::vector<KeyNoteData>& keynotes)
-      : lanes(lanes_), fragments(fragments_), msPerFragment(mpf), notes(keynotes) {
-    highway.reserve(lanes);
-    for (uint8_t i = 0; i < lanes; ++i) {
-      highway.emplace_back(mystd::circulate<int8_t, mystd::vector<int8_t>>(
-          mystd::vector<int8_t>(fragments, 0)));
-    }
+  CenterEffects centerEffects;
+
+  // Constant tempo, `mpf` ms per fragment
+  Game(std::size_t lanes_, std::size_t fragments_, uint32_t mpf,
+       mystd::span<const KeyNoteData> keynotes)
+      : Game(lanes_, fragments_, TimingMap(mpf), keynotes) {}
+
+  Game(std::size_t lanes_, std::size_t fragments_, const TimingMap &timing_,
+       mystd::span<const KeyNoteData> keynotes)
+      : notes(keynotes), lanes(lanes_), fragments(fragments_), timing(timing_),
+        highway(lanes_, fragments_) {
     lanePressed.assign(lanes, false);
     holdPressedTime.assign(lanes, 0);
+    holdOverflow.assign(lanes, 0);
     laneEffects.assign(lanes, {NO_LANE_EFFECT, 0});
+    indexNotes();
+  }
+
+  // Game time at which `fragment` is loaded
+  uint32_t fragmentMs(std::size_t fragment) const {
+    return timing.fragmentMs(fragment);
+  }
+
+  // Length of the current fragment in ms
+  uint32_t fragmentLengthMs() const {
+    return timing.fragmentLengthMs(nowFragment);
+  }
+
+  // Time for a note to cross the screen at the current tempo; effects last
+  // a multiple of it
+  uint32_t screenMs() const {
+    return fragmentLengthMs() * static_cast<uint32_t>(fragments);
+  }
+
+  // Build noteIndex by counting notes per fragment; call again whenever
+  // `notes` is replaced
+  void indexNotes() {
+    std::size_t lastFragment = 0;
+    longestHold = 0;
+    for (const KeyNoteData &n : notes) {
+      lastFragment = std::max<std::size_t>(lastFragment, n.startFragment);
+      if (n.holds > 0)
+        longestHold = std::max(longestHold, static_cast<std::size_t>(n.holds));
+    }
+
+    noteIndex.assign(notes.empty() ? 1 : lastFragment + 2, 0);
+    for (const KeyNoteData &n : notes)
+      noteIndex[n.startFragment + 1]++;
+    for (std::size_t f = 1; f < noteIndex.size(); ++f)
+      noteIndex[f] += noteIndex[f - 1];
+  }
+
+  // Put the highway in the state it has after `fragment` loadFragment() calls
+  // with nothing hit yet. Only the visible window (plus the longest hold that
+  // can reach into it) is replayed, so this does not depend on chart length.
+  void seek(std::size_t fragment) {
+    std::size_t windowBegin = fragment > fragments ? fragment - fragments : 0;
+    std::size_t replayBegin =
+        windowBegin > longestHold ? windowBegin - longestHold : 0;
+
+    // Full remaining hold length per lane, capped into the cells
+    mystd::vector<int32_t> carry(lanes, 0);
+    for (std::size_t f = replayBegin; f < fragment; ++f) {
+      for (std::size_t lane = 0; lane < lanes; ++lane)
+        carry[lane] = carry[lane] > 1 ? carry[lane] - 1 : 0;
+      for (const KeyNoteData &nd : notesAt(f))
+        if (nd.lane < lanes)
+          carry[nd.lane] = nd.isTap() ? -1 : nd.holds;
+
+      if (f >= windowBegin) {
+        int8_t *row = highway.row(fragment - 1 - f);
+        for (std::size_t lane = 0; lane < lanes; ++lane)
+          row[lane] = static_cast<int8_t>(
+              std::min<int32_t>(carry[lane], HOLD_CELL_MAX));
+      }
+    }
+    for (std::size_t lane = 0; lane < lanes; ++lane)
+      holdOverflow[lane] =
+          carry[lane] > HOLD_CELL_MAX ? carry[lane] - HOLD_CELL_MAX : 0;
+    for (std::size_t f = fragment - windowBegin; f < fragments; ++f) {
+      int8_t *row = highway.row(f);
+      for (std::size_t lane = 0; lane < lanes; ++lane)
+        row[lane] = 0;
+    }
+
+    nowFragment = fragment;
+    lanePressed.assign(lanes, false);
+    holdPressedTime.assign(lanes, 0);
+    laneEffects.assign(lanes, {NO_LANE_EFFECT, 0, 0});
+    centerEffects.clear();
+  }
+
+  // Start over at `fragment` with all counters cleared
+  void restart(std::size_t fragment = 0) {
+    score = perfectCount = greatCount = goodCount = badCount = missCount =
+        combo = maxCombo = heldTime = 0;
+    seek(fragment);
+  }
+
+  // Notes starting at `fragment`
+  mystd::span<const KeyNoteData> notesAt(std::size_t fragment) const {
+    if (fragment + 1 >= noteIndex.size())
+      return {};
+    return notes.subspan(noteIndex[fragment],
+                         noteIndex[fragment + 1] - noteIndex[fragment]);
+  }
+
+  // Write every note starting at `fragment` into the top row `row`
+  inline void loadNotes(std::size_t fragment, int8_t *row) {
+    for (const KeyNoteData &nd : notesAt(fragment)) {
+      if (nd.lane >= lanes)
+        continue;
+      if (nd.isTap()) {
+        row[nd.lane] = -1;
+        holdOverflow[nd.lane] = 0;
+      } else if (nd.holds > HOLD_CELL_MAX) {
+        row[nd.lane] = HOLD_CELL_MAX;
+        holdOverflow[nd.lane] = nd.holds - HOLD_CELL_MAX;
+      } else {
+        row[nd.lane] = static_cast<int8_t>(nd.holds);
+        holdOverflow[nd.lane] = 0;
+      }
+    }
   }
 
   inline void addCombo(uint32_t nowMs) {
     combo++;
     maxCombo = std::max(maxCombo, combo);
     if (combo > 1)
-      centerEffects.push(
-          {nowMs + msPerFragment * (uint32_t)fragments * 3, COMBO, combo});
+      centerEffects.push({nowMs + screenMs() * 3, COMBO, combo});
   }
 
   inline void resetCombo() { combo = 0; }
@@ -91,14 +242,12 @@ public:
       if (i.endTime <= nowMs)
         i = {NO_LANE_EFFECT, 0};
 
-    while (!centerEffects.empty() && centerEffects.top().endTime <= nowMs) {
-      centerEffects.pop();
-    }
+    centerEffects.clearExpired(nowMs);
   }
 
   void addTapScore(uint32_t nowMs, std::size_t lane) {
-    double f =
-        (double)(nowMs - nowFragment * msPerFragment) / double(msPerFragment);
+    double f = (double)(nowMs - fragmentMs(nowFragment)) /
+               double(fragmentLengthMs());
 
     uint32_t prev = score / 1000;
 
@@ -128,73 +277,72 @@ public:
       resetCombo();
     }
 
-    laneEffects[lane].endTime = nowMs + msPerFragment * fragments;
+    laneEffects[lane].endTime = nowMs + screenMs();
 
     if ((score / 1000 - prev) > 0)
-      centerEffects.push(
-          {nowMs + msPerFragment * (uint32_t)fragments * 3, SCORE, score});
+      centerEffects.push({nowMs + screenMs() * 3, SCORE, score});
   }
 
+  // Scores the bottom hold cell for the time it was held at the judgement
+  // line. A key that went down before the cell got there counts from the
+  // start of the cell's fragment.
   void addHoldScore(uint32_t nowMs, std::size_t lane) {
-    uint32_t heldMs = nowMs - holdPressedTime[lane];
+    uint32_t since = std::max(holdPressedTime[lane], fragmentMs(nowFragment));
+    uint32_t heldMs = nowMs > since ? nowMs - since : 0;
     heldTime += heldMs;
-    double f = (double)heldMs * 400.0f / double(msPerFragment);
+    double f = (double)heldMs * 400.0f / double(fragmentLengthMs());
     laneEffects[lane].content &= CLEAR;
     laneEffects[lane].content |= HOLD_RELEASED;
-    laneEffects[lane].endTime = nowMs + msPerFragment * fragments;
+    laneEffects[lane].endTime = nowMs + screenMs();
     uint32_t prev = score / 1000;
     score += static_cast<uint32_t>(f);
-    if ((score / 1000 - prev) > 0) {
-      centerEffects.push(
-          {nowMs + msPerFragment * (uint32_t)fragments * 3, SCORE, score});
-      std::cout << "a";
-    }
+    if ((score / 1000 - prev) > 0)
+      centerEffects.push({nowMs + screenMs() * 3, SCORE, score});
   }
 
-  // Called every msPerFragment ms
+  // Called at fragmentMs(nowFragment + 1)
   void loadFragment(std::function<void(Game &)> foo = nullptr,
                     std::function<void(Game &)> bar = nullptr) {
     // 1. Process bottom fragments (misses + hold sustain end)
+    int8_t *bottom = highway.bottom();
+    uint32_t nowMs = fragmentMs(nowFragment + 1);
     for (std::size_t lane = 0; lane < lanes; ++lane) {
-      int8_t &bottom = highway[lane].back();
-      uint32_t nowMs = (nowFragment + 1) * msPerFragment;
-      if (bottom < 0) { // tap
+      if (bottom[lane] < 0) { // tap
         missCount++;
         laneEffects[lane].content &= CLEAR;
         laneEffects[lane].content |= MISS;
-        laneEffects[lane].endTime = nowMs + msPerFragment * fragments;
+        laneEffects[lane].endTime = nowMs + screenMs();
         resetCombo();
-        bottom = 0;
-      } else if (bottom > 0) { // hold
+        bottom[lane] = 0;
+      } else if (bottom[lane] > 0) { // hold
         if (lanePressed[lane]) {
           addHoldScore(nowMs, lane);
           holdPressedTime[lane] = nowMs;
         }
-        bottom = 0;
+        bottom[lane] = 0;
       }
     }
 
     if (foo)
       foo(*this);
 
-    // 2. Rotate all lanes
-    for (std::size_t lane = 0; lane < lanes; ++lane) {
-      highway[lane].rotate(-1);
-    }
+    // 2. Scroll all lanes at once; the old bottom row becomes the new top
+    highway.scroll();
 
     // 3. Fill new top from previous top (holds - 1)
+    int8_t *top = highway.top();
+    const int8_t *prev = highway.row(1);
     for (std::size_t lane = 0; lane < lanes; ++lane) {
-      highway[lane][0] = (highway[lane][1] > 1) ? highway[lane][1] - 1 : 0;
+      if (prev[lane] == HOLD_CELL_MAX && holdOverflow[lane] > 0) {
+        top[lane] = HOLD_CELL_MAX;
+        --holdOverflow[lane];
+      } else {
+        top[lane] = prev[lane] > 1 ? prev[lane] - 1 : 0;
+      }
     }
 
     // 4. Load new notes into top
-    while (loadNext < notes.size() &&
-           notes[loadNext].startFragment == nowFragment) {
-      const KeyNoteData &nd = notes[loadNext];
-      if (nd.lane < lanes)
-        highway[nd.lane][0] = nd.holds;
-      loadNext++;
-    }
+    loadNotes(nowFragment, top);
     nowFragment++;
 
     if (bar)
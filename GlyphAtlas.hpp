@@ -0,0 +1,171 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string_view>
+
+#include "include/vector.hpp"
+
+enum Alignment : uint8_t { ALIGN_LEFT, ALIGN_CENTER, ALIGN_RIGHT };
+
+// Printable ASCII of one TTF_Font rasterized once into a single white texture.
+// Strings are drawn as one batch of textured quads tinted by vertex color, so
+// steady-state text costs no TTF call, no texture and no allocation.
+class GlyphAtlas {
+private:
+  static constexpr char FIRST = 32; // ' '
+  static constexpr char LAST = 126; // '~'
+  static constexpr int ATLAS_WIDTH = 1024;
+
+  struct Glyph {
+    SDL_Rect src;
+    int advance;
+  };
+
+  SDL_Texture *texture = nullptr;
+  Glyph glyphs[LAST - FIRST + 1] = {};
+  int height = 0;
+
+  // Reused between draws, only ever grows
+  mystd::vector<SDL_Vertex> vertices;
+  mystd::vector<int> indices;
+
+public:
+  GlyphAtlas() = default;
+  GlyphAtlas(const GlyphAtlas &) = delete;
+  GlyphAtlas &operator=(const GlyphAtlas &) = delete;
+
+  ~GlyphAtlas() { destroy(); }
+
+  void destroy() {
+    if (texture)
+      SDL_DestroyTexture(texture);
+    texture = nullptr;
+  }
+
+  bool build(SDL_Renderer *rnd, TTF_Font *font) {
+    destroy();
+    height = TTF_FontHeight(font);
+
+    // Shelf-pack the glyphs into rows of ATLAS_WIDTH
+    SDL_Surface *rendered[LAST - FIRST + 1] = {};
+    int x = 0, y = 0;
+    for (char c = FIRST; c <= LAST; ++c) {
+      Glyph &g = glyphs[c - FIRST];
+      int minx, maxx, miny, maxy;
+      TTF_GlyphMetrics(font, static_cast<Uint16>(c), &minx, &maxx, &miny,
+                       &maxy, &g.advance);
+
+      SDL_Surface *s = TTF_RenderGlyph_Blended(font, static_cast<Uint16>(c),
+                                               {255, 255, 255, 255});
+      rendered[c - FIRST] = s;
+      int w = s ? s->w : 0;
+      if (x + w > ATLAS_WIDTH) {
+        x = 0;
+        y += height;
+      }
+      g.src = {x, y, w, s ? s->h : 0};
+      x += w;
+    }
+
+    SDL_Surface *sheet = SDL_CreateRGBSurfaceWithFormat(
+        0, ATLAS_WIDTH, y + height, 32, SDL_PIXELFORMAT_RGBA32);
+    if (sheet) {
+      for (char c = FIRST; c <= LAST; ++c) {
+        SDL_Surface *s = rendered[c - FIRST];
+        if (!s)
+          continue;
+        SDL_SetSurfaceBlendMode(s, SDL_BLENDMODE_NONE);
+        SDL_Rect dst = glyphs[c - FIRST].src;
+        SDL_BlitSurface(s, nullptr, sheet, &dst);
+      }
+      texture = SDL_CreateTextureFromSurface(rnd, sheet);
+      SDL_FreeSurface(sheet);
+    }
+    for (SDL_Surface *s : rendered)
+      if (s)
+        SDL_FreeSurface(s);
+
+    if (!texture) {
+      std::cerr << "Failed to build glyph atlas: " << SDL_GetError()
+                << std::endl;
+      return false;
+    }
+    SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+    return true;
+  }
+
+  bool canDraw(std::string_view text) const {
+    if (!texture)
+      return false;
+    for (char c : text)
+      if (c < FIRST || c > LAST)
+        return false;
+    return true;
+  }
+
+  int measure(std::string_view text) const {
+    int w = 0;
+    for (char c : text)
+      w += glyphs[c - FIRST].advance;
+    return w;
+  }
+
+  // Same placement as a TTF_RenderText texture: y is the vertical centre
+  void draw(SDL_Renderer *rnd, std::string_view text, int x, int y,
+            SDL_Color color, Alignment align = ALIGN_LEFT) {
+    append(text, x, y, color, align);
+    flush(rnd);
+  }
+
+  // Queue text without drawing it, so many strings share one flush()
+  void append(std::string_view text, int x, int y, SDL_Color color,
+              Alignment align = ALIGN_LEFT) {
+    if (align == ALIGN_CENTER)
+      x -= measure(text) / 2;
+    else if (align == ALIGN_RIGHT)
+      x -= measure(text);
+    float top = static_cast<float>(y - height / 2);
+
+    float pen = static_cast<float>(x);
+    for (char c : text) {
+      const Glyph &g = glyphs[c - FIRST];
+      if (g.src.w > 0) {
+        int base = static_cast<int>(vertices.size());
+        float u0 = static_cast<float>(g.src.x) / ATLAS_WIDTH;
+        float u1 = static_cast<float>(g.src.x + g.src.w) / ATLAS_WIDTH;
+        float v0 = static_cast<float>(g.src.y) / textureHeight();
+        float v1 = static_cast<float>(g.src.y + g.src.h) / textureHeight();
+        float x1 = pen + g.src.w, y1 = top + g.src.h;
+
+        vertices.push_back({{pen, top}, color, {u0, v0}});
+        vertices.push_back({{x1, top}, color, {u1, v0}});
+        vertices.push_back({{x1, y1}, color, {u1, v1}});
+        vertices.push_back({{pen, y1}, color, {u0, v1}});
+        for (int i : {0, 1, 2, 0, 2, 3})
+          indices.push_back(base + i);
+      }
+      pen += g.advance;
+    }
+  }
+
+  // Submit everything appended so far, returns the number of draw calls made
+  int flush(SDL_Renderer *rnd) {
+    if (vertices.empty())
+      return 0;
+    SDL_RenderGeometry(rnd, texture, vertices.data(),
+                       static_cast<int>(vertices.size()), indices.data(),
+                       static_cast<int>(indices.size()));
+    vertices.clear();
+    indices.clear();
+    return 1;
+  }
+
+private:
+  float textureHeight() const {
+    return static_cast<float>(glyphs[LAST - FIRST].src.y + height);
+  }
+};
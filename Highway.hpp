@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "include/vector.hpp"
+
+// int8_t: -1 = tap, -2 = invisible tap, >=1 = number of remaining fragments to
+// hold, 0 = empty
+//
+// All lanes share one lanes x fragments buffer, stored row by row (one row =
+// one fragment across every lane) behind a single ring offset. Fragment 0 is
+// the top of the screen, fragment `fragments() - 1` the judgement line.
+class Highway {
+private:
+  std::size_t lanes_ = 0;
+  std::size_t fragments_ = 0;
+  std::size_t start = 0; // physical row of fragment 0
+  mystd::vector<int8_t> cells;
+
+  constexpr std::size_t physicalRow(std::size_t fragment) const noexcept {
+    std::size_t r = start + fragment;
+    return r >= fragments_ ? r - fragments_ : r;
+  }
+
+public:
+  // Column of one lane, keeps the highway[lane][fragment] syntax
+  template <class Cell> class LaneView {
+    Cell *data;
+    std::size_t lane, lanes, fragments, start;
+
+  public:
+    constexpr LaneView(Cell *data_, std::size_t lane_, std::size_t lanes_,
+                       std::size_t fragments_, std::size_t start_) noexcept
+        : data(data_), lane(lane_), lanes(lanes_), fragments(fragments_),
+          start(start_) {}
+
+    constexpr Cell &operator[](std::size_t fragment) const noexcept {
+      std::size_t r = start + fragment;
+      if (r >= fragments)
+        r -= fragments;
+      return data[r * lanes + lane];
+    }
+
+    constexpr std::size_t size() const noexcept { return fragments; }
+    constexpr Cell &front() const noexcept { return (*this)[0]; }
+    constexpr Cell &back() const noexcept { return (*this)[fragments - 1]; }
+  };
+
+  Highway() = default;
+
+  Highway(std::size_t lanes, std::size_t fragments)
+      : lanes_(lanes), fragments_(fragments), cells(lanes * fragments, 0) {}
+
+  constexpr std::size_t lanes() const noexcept { return lanes_; }
+  constexpr std::size_t fragments() const noexcept { return fragments_; }
+  constexpr std::size_t getStart() const noexcept { return start; }
+  constexpr void setStart(std::size_t start_) noexcept {
+    start = fragments_ == 0 ? 0 : start_ % fragments_;
+  }
+
+  // All lanes of one fragment, contiguous
+  constexpr int8_t *row(std::size_t fragment) noexcept {
+    return cells.data() + physicalRow(fragment) * lanes_;
+  }
+  constexpr const int8_t *row(std::size_t fragment) const noexcept {
+    return cells.data() + physicalRow(fragment) * lanes_;
+  }
+
+  constexpr int8_t *top() noexcept { return row(0); }
+  constexpr int8_t *bottom() noexcept { return row(fragments_ - 1); }
+  constexpr const int8_t *bottom() const noexcept {
+    return row(fragments_ - 1);
+  }
+
+  constexpr LaneView<int8_t> operator[](std::size_t lane) noexcept {
+    return {cells.data(), lane, lanes_, fragments_, start};
+  }
+  constexpr LaneView<const int8_t> operator[](std::size_t lane) const noexcept {
+    return {cells.data(), lane, lanes_, fragments_, start};
+  }
+
+  // Scroll every lane down by one fragment: the old bottom row becomes the new
+  // (stale) top row, to be overwritten by the caller
+  constexpr void scroll() noexcept {
+    if (fragments_ != 0)
+      start = start == 0 ? fragments_ - 1 : start - 1;
+  }
+
+  // Raw buffer in physical order, e.g. for wholesale copies
+  constexpr int8_t *data() noexcept { return cells.data(); }
+  constexpr const int8_t *data() const noexcept { return cells.data(); }
+  constexpr std::size_t size() const noexcept { return cells.size(); }
+};
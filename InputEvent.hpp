@@ -0,0 +1,11 @@
+#pragma once
+
+#include <cstdint>
+
+// One key transition, timed in ms since the game started (the same clock
+// RhythmQuest.cpp passes to Game::keyPressed / Game::keyReleased)
+struct InputEvent {
+  uint32_t timeMs;
+  uint32_t lane;
+  bool pressed; // true: key down, false: key up
+};
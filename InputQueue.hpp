@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+#include "include/array.hpp"
+
+#include "InputEvent.hpp"
+
+// Lock-free single-producer/single-consumer ring. N must be a power of two;
+// one slot is never used so that head == tail always means empty.
+template <class T, std::size_t N> class SpscRing {
+  static_assert(N >= 2 && (N & (N - 1)) == 0, "N must be a power of two");
+
+private:
+  alignas(64) std::atomic<std::size_t> head{0}; // written by the consumer
+  alignas(64) std::atomic<std::size_t> tail{0}; // written by the producer
+  alignas(64) mystd::array<T, N> buffer;
+
+public:
+  // Producer side, returns false when full
+  bool push(const T &value) {
+    std::size_t t = tail.load(std::memory_order_relaxed);
+    std::size_t next = (t + 1) & (N - 1);
+    if (next == head.load(std::memory_order_acquire))
+      return false;
+    buffer[t] = value;
+    tail.store(next, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side, returns nullptr when empty. The pointer stays valid until
+  // pop()
+  const T *front() const {
+    std::size_t h = head.load(std::memory_order_relaxed);
+    if (h == tail.load(std::memory_order_acquire))
+      return nullptr;
+    return &buffer[h];
+  }
+
+  void pop() {
+    std::size_t h = head.load(std::memory_order_relaxed);
+    head.store((h + 1) & (N - 1), std::memory_order_release);
+  }
+
+  bool pop(T &value) {
+    const T *v = front();
+    if (!v)
+      return false;
+    value = *v;
+    pop();
+    return true;
+  }
+
+  bool empty() const { return front() == nullptr; }
+};
+
+// Key transitions handed from the event watch to the simulation thread.
+// Under SDL2 the watch runs inside SDL_PumpEvents on the main thread and
+// event.key.timestamp is the SDL_GetTicks() of that pump, so the times are
+// only as fine as the main loop's pumping (about 1 ms between frames).
+using InputQueue = SpscRing<InputEvent, 256>;
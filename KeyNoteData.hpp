@@ -1,7 +1,37 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+// 8 bytes, eight notes per cache line. Built as {startFragment, lane, holds}
+// with holds = -1 for a tap, as before the record was packed. Values too
+// wide for a field saturate instead of wrapping: holds are cut to MAX_HOLD
+// and a lane past 255 stays out of range for every game.
 struct KeyNoteData {
-    std::size_t startFragment;
-    std::size_t lane;
-    int8_t holds;  // -1=TAP, >=1=持續fragments
-};
\ No newline at end of file
+    static constexpr uint8_t TAP = 1;              // flags bit
+    static constexpr std::size_t MAX_HOLD = 65535; // longer holds are cut
+    static constexpr std::size_t MAX_LANE = 255;
+    static constexpr std::size_t MAX_FRAGMENT = UINT32_MAX;
+
+    uint32_t startFragment;
+    uint16_t holds;  // 持續fragments, 0 for taps
+    uint8_t lane;
+    uint8_t flags;
+
+    KeyNoteData() = default;
+    constexpr KeyNoteData(std::size_t start, std::size_t lane_, int holds_)
+        : startFragment(static_cast<uint32_t>(
+              start < MAX_FRAGMENT ? start : MAX_FRAGMENT)),
+          holds(static_cast<uint16_t>(
+              holds_ <= 0 ? 0
+              : static_cast<std::size_t>(holds_) < MAX_HOLD ? holds_
+                                                            : MAX_HOLD)),
+          lane(static_cast<uint8_t>(lane_ < MAX_LANE ? lane_ : MAX_LANE)),
+          flags(holds_ < 0 ? TAP : 0) {}
+
+    constexpr bool isTap() const { return flags & TAP; }
+};
+
+static_assert(sizeof(KeyNoteData) == 8);
+static_assert(std::is_trivially_copyable_v<KeyNoteData>);
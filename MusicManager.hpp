@@ -1,6 +1,8 @@
 #pragma once
 
 #include <SDL2/SDL_mixer.h>
+#include <atomic>
+#include <cstdint>
 #include <string>
 #include <map>
 #include <iostream>
@@ -15,6 +17,53 @@ private:
     Uint32 musicStartTime;
     bool paused;
 
+    // Audio clock, fed from the mixer thread by postMix(): where the chunk
+    // being mixed starts (in frames since playMusic()) and when it was mixed.
+    // mixSeq is odd while the pair is being updated.
+    std::atomic<uint32_t> mixSeq{0};
+    std::atomic<uint64_t> chunkStartFrame{0};
+    std::atomic<uint64_t> chunkCounter{0};
+    std::atomic<bool> clockRunning{false};
+    // resetClock() bumps resetRequested; postMix() zeroes mixedFrames and
+    // publishes the generation it applied, so only the mixer thread ever
+    // writes the clock.
+    std::atomic<uint32_t> resetRequested{0};
+    std::atomic<uint32_t> resetApplied{0};
+    uint64_t mixedFrames = 0;  // mixer thread only
+    int sampleRate = 44100;
+    int bytesPerFrame = 4;
+    // Device buffer, i.e. output latency: what postMix() is handed per
+    // callback, the requested size until the first one
+    std::atomic<int> bufferFrames{2048};
+    mutable Uint32 lastMusicTime = 0;
+
+    static void postMix(void* udata, Uint8*, int len) {
+        MusicManager* self = static_cast<MusicManager*>(udata);
+        uint32_t generation = self->resetRequested.load(std::memory_order_acquire);
+        bool reset = generation != self->resetApplied.load(std::memory_order_relaxed);
+        bool running = self->clockRunning.load(std::memory_order_relaxed);
+        if (!reset && !running) return;
+
+        int frames = len / self->bytesPerFrame;
+        self->bufferFrames.store(frames, std::memory_order_relaxed);
+        if (reset) self->mixedFrames = 0;
+
+        self->mixSeq.fetch_add(1, std::memory_order_acq_rel);
+        self->chunkStartFrame.store(self->mixedFrames, std::memory_order_relaxed);
+        self->chunkCounter.store(SDL_GetPerformanceCounter(), std::memory_order_relaxed);
+        self->mixSeq.fetch_add(1, std::memory_order_release);
+        self->resetApplied.store(generation, std::memory_order_release);
+
+        if (running) self->mixedFrames += static_cast<uint64_t>(frames);
+    }
+
+    // Game thread; the clock reads 0 until the mixer has applied the reset
+    void resetClock(bool running) {
+        clockRunning.store(running, std::memory_order_relaxed);
+        resetRequested.fetch_add(1, std::memory_order_release);
+        lastMusicTime = 0;
+    }
+
 public:
     MusicManager() 
         : bgMusic(nullptr), initialized(false), 
@@ -35,6 +84,13 @@ public:
             return false;
         }
 
+        Uint16 format;
+        int channels;
+        if (Mix_QuerySpec(&sampleRate, &format, &channels)) {
+            bytesPerFrame = SDL_AUDIO_BITSIZE(format) / 8 * channels;
+        }
+        Mix_SetPostMix(postMix, this);
+
         Mix_AllocateChannels(16);
         initialized = true;
         std::cout << "[OK] MusicManager initialized" << std::endl;
@@ -71,6 +127,7 @@ public:
 
         musicStartTime = SDL_GetTicks();
         paused = false;
+        resetClock(true);
         std::cout << "[INFO] Music started" << std::endl;
     }
 
@@ -78,6 +135,7 @@ public:
         if (Mix_PlayingMusic() && !paused) {
             Mix_PauseMusic();
             paused = true;
+            clockRunning.store(false, std::memory_order_relaxed);
         }
     }
 
@@ -85,12 +143,14 @@ public:
         if (paused) {
             Mix_ResumeMusic();
             paused = false;
+            clockRunning.store(true, std::memory_order_relaxed);
         }
     }
 
     void stopMusic() {
         Mix_HaltMusic();
         paused = false;
+        clockRunning.store(false, std::memory_order_relaxed);
     }
 
     void setMusicVolume(int volume) {
@@ -98,9 +158,35 @@ public:
         Mix_VolumeMusic(musicVolume);
     }
 
+    // Playback position in ms, from the frames actually mixed minus the
+    // device buffer still ahead of the speakers, interpolated between mixer
+    // callbacks. Monotonic; frozen while paused.
     Uint32 getMusicTime() const {
-        if (!Mix_PlayingMusic() || paused) return 0;
-        return SDL_GetTicks() - musicStartTime;
+        if (resetApplied.load(std::memory_order_acquire) !=
+            resetRequested.load(std::memory_order_relaxed))
+            return lastMusicTime;
+
+        uint64_t startFrame, counter;
+        uint32_t seq;
+        do {
+            seq = mixSeq.load(std::memory_order_acquire);
+            startFrame = chunkStartFrame.load(std::memory_order_relaxed);
+            counter = chunkCounter.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+        } while ((seq & 1) || seq != mixSeq.load(std::memory_order_relaxed));
+
+        int buffer = bufferFrames.load(std::memory_order_relaxed);
+        double ms = (double(startFrame) - buffer) * 1000.0 / sampleRate;
+        if (clockRunning.load(std::memory_order_relaxed)) {
+            double sinceMix = double(SDL_GetPerformanceCounter() - counter) * 1000.0 /
+                              double(SDL_GetPerformanceFrequency());
+            double chunkMs = buffer * 1000.0 / sampleRate;
+            ms += sinceMix < chunkMs ? sinceMix : chunkMs;
+        }
+
+        Uint32 now = ms > 0 ? static_cast<Uint32>(ms) : 0;
+        if (now > lastMusicTime) lastMusicTime = now;
+        return lastMusicTime;
     }
 
     bool loadSoundEffect(const std::string& name, const std::string& filepath) {
@@ -146,6 +232,7 @@ public:
         Mix_FadeInMusic(bgMusic, loops, ms);
         musicStartTime = SDL_GetTicks();
         paused = false;
+        resetClock(true);
     }
 
     void fadeOutMusic(int ms) {
@@ -164,6 +251,7 @@ public:
         sfxMap.clear();
 
         if (initialized) {
+            Mix_SetPostMix(nullptr, nullptr);
             Mix_CloseAudio();
             initialized = false;
         }
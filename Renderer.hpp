@@ -3,36 +3,89 @@
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_image.h>
 #include <SDL2/SDL_ttf.h>
+#include <algorithm>
 #include <cmath>
 #include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
 #include <iostream>
 #include <string>
-#include <tuple>
-#include <unordered_map>
+#include <string_view>
+#include <utility>
 
-#include "include/tuple.hpp"
+#include "include/array.hpp"
 
+#include "FramePacer.hpp"
 #include "Game.hpp"
+#include "GlyphAtlas.hpp"
+#include "TextureCache.hpp"
+#include "ViewState.hpp"
+
+// Note swatches in the notes atlas
+enum NoteSwatch : uint8_t {
+  SWATCH_EMPTY,
+  SWATCH_TAP,
+  SWATCH_HOLD,
+  SWATCH_WHITE, // pressed holds, tinted per vertex with the hold pulse
+  SWATCH_COUNT
+};
 
-enum Alignment : uint8_t { ALIGN_LEFT, ALIGN_CENTER, ALIGN_RIGHT };
+// Judgement and HUD images, also their ids in the image cache
+enum EffectImage : uint8_t {
+  IMAGE_PERFECT,
+  IMAGE_GREAT,
+  IMAGE_GOOD,
+  IMAGE_BAD,
+  IMAGE_MISS,
+  IMAGE_HOLD_RELEASED,
+  IMAGE_COMBO,
+  IMAGE_SCORE,
+  EFFECT_IMAGE_COUNT
+};
 
-struct NotesCacheHash {
-  std::size_t operator()(const mystd::tuple<int8_t, bool, uint32_t> &t) const {
-    auto hash1 = std::hash<int8_t>{}(mystd::get<0>(t));
-    auto hash2 = std::hash<bool>{}(mystd::get<1>(t));
-    auto hash3 = std::hash<uint32_t>{}(mystd::get<2>(t));
-    return hash1 ^ (hash2 << 1) ^ (hash3 << 2);
-  }
+constexpr const char *EFFECT_IMAGE_PATHS[EFFECT_IMAGE_COUNT] = {
+    "res/img/perfect.png", "res/img/great.png", "res/img/good.png",
+    "res/img/bad.png",     "res/img/miss.png",  "res/img/hold_released.png",
+    "res/img/combo.png",   "res/img/score.png"};
+
+// Work submitted by the last Renderer::render call
+struct RenderStats {
+  uint32_t drawCalls = 0;
+  uint32_t textureCreations = 0;
 };
 
 class Renderer {
 private:
-  Game &game;
-  std::unordered_map<mystd::tuple<int8_t, bool, uint32_t>, SDL_Texture *,
-                     NotesCacheHash>
-      notesTextureCache;
-  std::unordered_map<std::string, SDL_Texture *> textTextureCache;
-  std::unordered_map<std::string, SDL_Texture *> imageTextureCache;
+  std::size_t lanes;
+  std::size_t fragments;
+  // Every note visual is a solid swatch in this one texture, created once and
+  // stretched to the cell size when drawn, so it survives resizes
+  SDL_Texture *notesAtlas = nullptr;
+  static constexpr int SWATCH_SIZE = 8;
+  // Rebuilt every frame, capacity kept between frames
+  mystd::vector<SDL_Vertex> highwayVertices;
+  mystd::vector<int> highwayIndices;
+  // Highway cells and hold counters as of the last change, drawn scrolled
+  SDL_Texture *highwayLayer = nullptr;
+  int highwayLayerW = 0;
+  int highwayLayerH = 0;
+  uint16_t composedStart = 0;
+  mystd::vector<int8_t> composedCells;
+  RenderStats current;
+  mystd::vector<SDL_Rect> pacingBars;
+  // Everything that only changes with the window size or lane count, drawn
+  // over the notes with a transparent background
+  SDL_Texture *staticLayer = nullptr;
+  std::size_t staticLanes = 0;
+  std::size_t staticFragments = 0;
+  // HUD text comes from the glyph atlases; the text cache is only the
+  // fallback for strings they cannot draw
+  GlyphAtlas largeGlyphs, mediumGlyphs, smallGlyphs;
+  // Source size of every decoded effect image ({0, 0} until loaded), mips
+  // live in imageCache under image * IMAGE_LEVELS + level
+  static constexpr int IMAGE_LEVELS = 5;
+  mystd::array<std::pair<int, int>, EFFECT_IMAGE_COUNT> imageSizes{};
 
   int screenW;
   int screenH;
@@ -47,296 +100,329 @@ private:
 
 public:
   float fps;
-
-  Renderer(Game &game_, int screenW_, int screenH_, SDL_Renderer *renderer,
-           TTF_Font *large_font_, TTF_Font *medium_font_, TTF_Font *small_font_)
-      : game(game_), screenW(screenW_), screenH(screenH_),
+  RenderStats stats; // last complete frame
+  TextureCache textCache{"text", 16 << 20};
+  BasicTextureCache<uint32_t> imageCache{"image", 64 << 20};
+
+  Renderer(std::size_t lanes_, std::size_t fragments_, int screenW_,
+           int screenH_, SDL_Renderer *renderer, TTF_Font *large_font_,
+           TTF_Font *medium_font_, TTF_Font *small_font_)
+      : lanes(lanes_), fragments(fragments_), screenW(screenW_),
+        screenH(screenH_),
         sdl_renderer(renderer), large_font(large_font_),
         medium_font(medium_font_), small_font(small_font_), fps(0) {
-    laneWidth = screenW / game.lanes;
-    fragmentHeight = screenH / game.fragments;
+    laneWidth = screenW / lanes;
+    fragmentHeight = screenH / fragments;
 
+    createNotesAtlas();
+    largeGlyphs.build(sdl_renderer, large_font);
+    mediumGlyphs.build(sdl_renderer, medium_font);
+    smallGlyphs.build(sdl_renderer, small_font);
     loadEffectImages();
   }
 
-  ~Renderer() { clearCache(); }
+  ~Renderer() {
+    clearCache();
+    if (notesAtlas)
+      SDL_DestroyTexture(notesAtlas);
+    if (staticLayer)
+      SDL_DestroyTexture(staticLayer);
+    if (highwayLayer)
+      SDL_DestroyTexture(highwayLayer);
+  }
+
+  // Draws a published view, nowMs only moves the smooth scroll offset.
+  // With a pacer, its frame-time graph is drawn on top.
+  void render(SDL_Renderer *rnd, const ViewState &view, uint32_t nowMs,
+              const FramePacer *pacer = nullptr) {
+    current = RenderStats();
 
-  void render(SDL_Renderer *rnd, uint32_t offsetMs) {
     SDL_SetRenderDrawColor(rnd, 80, 80, 180, 80);
     SDL_RenderClear(rnd);
 
-    // Draw game field
-    SDL_SetRenderDrawColor(rnd, 100, 100, 100, 255);
-    for (std::size_t lane = 1; lane < game.lanes; ++lane) {
-      int x = lane * laneWidth;
-      SDL_RenderDrawLine(rnd, x, 0, x, screenH);
-    }
-
-    SDL_SetRenderDrawColor(rnd, 60, 60, 60, 255);
-    for (std::size_t fragment = 1; fragment < game.fragments; ++fragment) {
-      int y = fragment * fragmentHeight;
-      SDL_RenderDrawLine(rnd, 0, y, screenW, y);
-    }
-
-    // Render notes
-    for (std::size_t lane = 0; lane < game.lanes; ++lane) {
-      bool lanePressed = game.lanePressed[lane];
-
-      for (std::size_t fragmentIdx = 0; fragmentIdx < game.fragments;
-           ++fragmentIdx) {
-        int8_t fragmentValue = game.highway[lane][fragmentIdx];
-        uint32_t holdTime = 0;
-
-        if (fragmentIdx == game.fragments - 1 && fragmentValue > 0 &&
-            lanePressed) {
-          holdTime = game.holdPressedTime[lane];
-        }
-
-        auto key = mystd::make_tuple(
-            fragmentValue, lanePressed && fragmentIdx == game.fragments - 1,
-            holdTime);
-
-        auto it = notesTextureCache.find(key);
-        SDL_Texture *texture;
-
-        if (it == notesTextureCache.end()) {
-          texture = createFragmentTexture(
-              rnd, fragmentValue,
-              lanePressed && fragmentIdx == game.fragments - 1, holdTime);
-          notesTextureCache[key] = texture;
-        } else {
-          texture = it->second;
-        }
+    if (view.lanes != lanes || view.fragments != fragments)
+      return;
 
-        SDL_Rect destRect;
-        destRect.x = lane * laneWidth;
-        double progress = (double)offsetMs / (double)game.msPerFragment;
-        if (progress > 1.0)
-          progress = 1.0;
-        double smoothY = (fragmentIdx + progress) * fragmentHeight;
+    if (!staticLayer || staticLanes != lanes || staticFragments != fragments)
+      buildStaticLayer();
 
-        destRect.y = (int)smoothY;
+    // Within a fragment only the scroll offset moves: the composed highway
+    // is rebuilt when its cells change and blitted at a sub-pixel offset
+    if (!highwayLayer || highwayChanged(view))
+      composeHighway(view);
 
-        destRect.w = laneWidth;
-        destRect.h = fragmentHeight;
+    float progress = (float)view.offsetMs(nowMs) / (float)view.msPerFragment;
+    if (progress > 1.0f)
+      progress = 1.0f;
+    float scrollY = progress * fragmentHeight;
 
-        SDL_RenderCopy(rnd, texture, nullptr, &destRect);
-      }
+    if (highwayLayer) {
+      SDL_FRect dest = {0, scrollY, (float)screenW,
+                        (float)(fragments * fragmentHeight)};
+      SDL_RenderCopyF(rnd, highwayLayer, nullptr, &dest);
+      ++current.drawCalls;
+    }
 
-      // Draw lane key hints
-      int laneCenterX = lane * laneWidth + laneWidth / 2;
-      std::string keyHint;
-      switch (lane) {
-      case 0:
-        keyHint = "A";
-        break;
-      case 1:
-        keyHint = "S";
-        break;
-      case 2:
-        keyHint = "D";
-        break;
-      case 3:
-        keyHint = "F";
-        break;
-      case 4:
-        keyHint = "G";
-        break;
-      case 5:
-        keyHint = "H";
-        break;
-      case 6:
-        keyHint = "J";
-        break;
-      case 7:
-        keyHint = "K";
-        break;
-      case 8:
-        keyHint = "L";
-        break;
-      default:
-        keyHint = std::to_string(lane + 1);
-        break;
-      }
-      drawText(rnd, keyHint, laneCenterX, screenH - 30, small_font,
-               {200, 200, 200, 255}, ALIGN_CENTER);
+    // Pressed holds pulse every frame, drawn over the composed cells
+    highwayVertices.clear();
+    highwayIndices.clear();
+    char text[64];
+    const int8_t *bottom = view.row(fragments - 1);
+    float bottomY = (fragments - 1) * fragmentHeight + scrollY;
+    for (std::size_t lane = 0; lane < lanes; ++lane) {
+      if (bottom[lane] <= 0 || !view.pressed(lane))
+        continue;
+      float pulse = 0.7f + 0.3f * sin(view.holdPressedTime[lane] / 100.0f);
+      pushQuad(lane * laneWidth + 1.0f, bottomY + 1, laneWidth - 2,
+               fragmentHeight - 2, SWATCH_WHITE,
+               {0, static_cast<Uint8>(150 * pulse), 0, 255});
+      std::snprintf(text, sizeof text, "%d", bottom[lane]);
+      queueText(rnd, text, lane * laneWidth + laneWidth / 2,
+                (int)bottomY + fragmentHeight / 2, {255, 255, 255, 255},
+                ALIGN_CENTER);
     }
+    current.drawCalls += submitQuads(rnd);
+    current.drawCalls += smallGlyphs.flush(rnd);
 
-    // Draw judgement line
-    SDL_SetRenderDrawColor(rnd, 255, 255, 255, 255);
-    int judgmentLineY = screenH - fragmentHeight;
-    SDL_Rect judgmentLine = {0, judgmentLineY, screenW, 3};
-    SDL_RenderFillRect(rnd, &judgmentLine);
+    // Grid, key hints and judgement line
+    if (staticLayer) {
+      SDL_RenderCopy(rnd, staticLayer, nullptr, nullptr);
+      ++current.drawCalls;
+    }
 
     // Draw score at top center
-    drawText(rnd, "Score: " + std::to_string(game.score), screenW / 2, 30,
-             medium_font, {255, 255, 255, 255}, ALIGN_CENTER);
+    std::snprintf(text, sizeof text, "Score: %u", view.score);
+    drawText(rnd, text, screenW / 2, 30, medium_font, {255, 255, 255, 255},
+             ALIGN_CENTER);
 
     // Draw stats on left
     const int statsX = 20;
     const int statsY = 30;
     const int lineHeight = 40;
 
-    drawText(rnd, "PERFECT: " + std::to_string(game.perfectCount), statsX,
-             statsY, small_font, {0, 255, 0, 255});
-    drawText(rnd, "GREAT: " + std::to_string(game.greatCount), statsX,
-             statsY + lineHeight, small_font, {0, 200, 100, 255});
-    drawText(rnd, "GOOD: " + std::to_string(game.goodCount), statsX,
-             statsY + lineHeight * 2, small_font, {200, 200, 0, 255});
-    drawText(rnd, "BAD: " + std::to_string(game.badCount), statsX,
-             statsY + lineHeight * 3, small_font, {255, 100, 0, 255});
-    drawText(rnd, "MISS: " + std::to_string(game.missCount), statsX,
-             statsY + lineHeight * 4, small_font, {255, 0, 0, 255});
-    drawText(rnd, "COMBO: " + std::to_string(game.combo), statsX,
-             statsY + lineHeight * 5, small_font, {255, 255, 255, 255});
-    drawText(rnd, "MAX COMBO: " + std::to_string(game.maxCombo), statsX,
-             statsY + lineHeight * 6, small_font, {255, 255, 255, 255});
-    drawText(rnd, "HELD TIME: " + std::to_string(game.heldTime) + " ms", statsX,
-             statsY + lineHeight * 7, small_font, {100, 255, 100, 255});
+    std::snprintf(text, sizeof text, "PERFECT: %u", view.perfectCount);
+    drawText(rnd, text, statsX, statsY, small_font, {0, 255, 0, 255});
+    std::snprintf(text, sizeof text, "GREAT: %u", view.greatCount);
+    drawText(rnd, text, statsX, statsY + lineHeight, small_font,
+             {0, 200, 100, 255});
+    std::snprintf(text, sizeof text, "GOOD: %u", view.goodCount);
+    drawText(rnd, text, statsX, statsY + lineHeight * 2, small_font,
+             {200, 200, 0, 255});
+    std::snprintf(text, sizeof text, "BAD: %u", view.badCount);
+    drawText(rnd, text, statsX, statsY + lineHeight * 3, small_font,
+             {255, 100, 0, 255});
+    std::snprintf(text, sizeof text, "MISS: %u", view.missCount);
+    drawText(rnd, text, statsX, statsY + lineHeight * 4, small_font,
+             {255, 0, 0, 255});
+    std::snprintf(text, sizeof text, "COMBO: %u", view.combo);
+    drawText(rnd, text, statsX, statsY + lineHeight * 5, small_font,
+             {255, 255, 255, 255});
+    std::snprintf(text, sizeof text, "MAX COMBO: %u", view.maxCombo);
+    drawText(rnd, text, statsX, statsY + lineHeight * 6, small_font,
+             {255, 255, 255, 255});
+    std::snprintf(text, sizeof text, "HELD TIME: %u ms", view.heldTime);
+    drawText(rnd, text, statsX, statsY + lineHeight * 7, small_font,
+             {100, 255, 100, 255});
 
     // Draw info on right
-    drawText(rnd, "Fragment: " + std::to_string(game.nowFragment), screenW - 20,
-             30, small_font, {200, 200, 200, 255}, ALIGN_RIGHT);
-    drawText(rnd, "FPS: " + std::to_string(fps), screenW - 20, 70, small_font,
-             {200, 200, 200, 255}, ALIGN_RIGHT);
+    std::snprintf(text, sizeof text, "Fragment: %u", view.nowFragment);
+    drawText(rnd, text, screenW - 20, 30, small_font, {200, 200, 200, 255},
+             ALIGN_RIGHT);
+    std::snprintf(text, sizeof text, "FPS: %.1f", fps);
+    drawText(rnd, text, screenW - 20, 70, small_font, {200, 200, 200, 255},
+             ALIGN_RIGHT);
+    std::snprintf(text, sizeof text, "Draw calls: %u  Textures: %u",
+                  stats.drawCalls, stats.textureCreations);
+    drawText(rnd, text, screenW - 20, 110, small_font, {200, 200, 200, 255},
+             ALIGN_RIGHT);
+    int cacheY = 150;
+    auto drawCacheStats = [&](const std::string &name,
+                              const TextureCacheStats &c) {
+      uint64_t lookups = c.hits + c.misses;
+      std::snprintf(text, sizeof text, "%s: %zu KB  %.1f%% hit  %llu evicted",
+                    name.c_str(), c.bytes >> 10,
+                    lookups ? 100.0 * c.hits / lookups : 100.0,
+                    static_cast<unsigned long long>(c.evictions));
+      drawText(rnd, text, screenW - 20, cacheY, small_font,
+               {200, 200, 200, 255}, ALIGN_RIGHT);
+      cacheY += 40;
+    };
+    drawCacheStats(textCache.name(), textCache.stats());
+    drawCacheStats(imageCache.name(), imageCache.stats());
 
     // Draw lane effects
-    for (std::size_t lane = 0; lane < game.lanes; ++lane) {
-      uint32_t effect = game.laneEffects[lane].content;
+    for (std::size_t lane = 0; lane < lanes; ++lane) {
+      uint32_t effect = view.laneEffects[lane].content;
       if (effect != NO_LANE_EFFECT) {
         drawLaneEffect(rnd, lane, effect);
       }
     }
 
     // Draw center effects
-    for (std::size_t i = 0; i < game.centerEffects.size(); ++i) {
-      drawCenterEffect(rnd, game.centerEffects.c[i].content,
-                       game.centerEffects.c[i].num);
+    for (const Effect &e : view.centerEffects) {
+      if (e.content != 0)
+        drawCenterEffect(rnd, e.content, e.num, view.combo);
     }
+
+    if (pacer)
+      drawPacingGraph(rnd, *pacer);
+
+    stats = current;
   }
 
   void clearCache() {
-    for (auto &pair : notesTextureCache) {
-      SDL_DestroyTexture(pair.second);
-    }
-    notesTextureCache.clear();
+    textCache.clear();
+    imageCache.clear();
+  }
 
-    for (auto &pair : textTextureCache) {
-      SDL_DestroyTexture(pair.second);
-    }
-    textTextureCache.clear();
+  void dumpCacheStats(std::ostream &out) const {
+    textCache.dump(out);
+    imageCache.dump(out);
+  }
 
-    for (auto &pair : imageTextureCache) {
-      SDL_DestroyTexture(pair.second);
+  bool dumpCacheStats(const char *path) const {
+    std::ofstream out(path);
+    if (!out.is_open()) {
+      std::cerr << "[ERROR] Cannot write cache stats: " << path << std::endl;
+      return false;
     }
-    imageTextureCache.clear();
+    dumpCacheStats(out);
+    return true;
   }
 
   void updateDimension(int screenW_, int screenH_) {
     if (screenW != screenW_ || screenH != screenH_) {
       screenW = screenW_;
       screenH = screenH_;
-      laneWidth = screenW / game.lanes;
-      fragmentHeight = screenH / game.fragments;
+      laneWidth = screenW / lanes;
+      fragmentHeight = screenH / fragments;
 
-      clearCache();
-      loadEffectImages();
+      // Atlases and cached images are size independent, only the static
+      // and highway layers depend on the window
+      buildStaticLayer();
+      composedCells.clear();
     }
   }
 
 private:
   void loadEffectImages() {
-    const char *effectImages[] = {
-        "res/img/perfect.png", "res/img/great.png", "res/img/good.png",
-        "res/img/bad.png",     "res/img/miss.png",  "res/img/hold_released.png",
-        "res/img/combo.png",   "res/img/score.png"};
-
-    for (const char *path : effectImages) {
-      std::string key = path;
-      SDL_Texture *texture = loadImageTexture(path);
-      if (texture) {
-        imageTextureCache[key] = texture;
-      }
-    }
+    for (int image = 0; image < EFFECT_IMAGE_COUNT; ++image)
+      getImageLevel(EffectImage(image), 0);
   }
 
   SDL_Texture *loadImageTexture(const char *path) {
     SDL_Texture *texture = IMG_LoadTexture(sdl_renderer, path);
+    ++current.textureCreations;
     if (!texture) {
       std::cerr << "Failed to load image " << path << ": " << IMG_GetError()
                 << std::endl;
       return nullptr;
     }
+    SDL_SetTextureScaleMode(texture, SDL_ScaleModeLinear);
+    return texture;
+  }
 
-    int originalWidth, originalHeight;
-    SDL_QueryTexture(texture, nullptr, nullptr, &originalWidth,
-                     &originalHeight);
-
-    float scaleFactor = screenW / 1080.0f / game.lanes;
-    int targetWidth = static_cast<int>(originalWidth * scaleFactor * 0.5f);
-    int targetHeight = static_cast<int>(originalHeight * scaleFactor * 0.5f);
-
-    SDL_Texture *scaledTexture =
-        SDL_CreateTexture(sdl_renderer, SDL_PIXELFORMAT_RGBA8888,
-                          SDL_TEXTUREACCESS_TARGET, targetWidth, targetHeight);
-    if (!scaledTexture) {
+  // Half-size copy; linear filtering at exact half scale averages 2x2 texels
+  SDL_Texture *halveTexture(SDL_Texture *texture) {
+    int w, h;
+    SDL_QueryTexture(texture, nullptr, nullptr, &w, &h);
+    SDL_Texture *half = SDL_CreateTexture(
+        sdl_renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET,
+        w > 1 ? w / 2 : 1, h > 1 ? h / 2 : 1);
+    ++current.textureCreations;
+    if (!half) {
       std::cerr << "Failed to create scaled texture: " << SDL_GetError()
                 << std::endl;
-      SDL_DestroyTexture(texture);
       return nullptr;
     }
-
-    SDL_SetTextureBlendMode(scaledTexture, SDL_BLENDMODE_BLEND);
+    SDL_SetTextureBlendMode(half, SDL_BLENDMODE_BLEND);
+    SDL_SetTextureScaleMode(half, SDL_ScaleModeLinear);
 
     SDL_Texture *prevTarget = SDL_GetRenderTarget(sdl_renderer);
-    SDL_SetRenderTarget(sdl_renderer, scaledTexture);
-
+    SDL_SetRenderTarget(sdl_renderer, half);
     SDL_SetRenderDrawColor(sdl_renderer, 0, 0, 0, 0);
     SDL_RenderClear(sdl_renderer);
-
-    SDL_Rect destRect = {0, 0, targetWidth, targetHeight};
-    SDL_RenderCopy(sdl_renderer, texture, nullptr, &destRect);
-
+    SDL_BlendMode mode;
+    SDL_GetTextureBlendMode(texture, &mode);
+    SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_NONE);
+    SDL_RenderCopy(sdl_renderer, texture, nullptr, nullptr);
+    SDL_SetTextureBlendMode(texture, mode);
     SDL_SetRenderTarget(sdl_renderer, prevTarget);
+    return half;
+  }
 
-    SDL_DestroyTexture(texture);
+  // Image at mip `level` (source size >> level). The PNG is decoded once,
+  // each level is halved from the one above when first needed.
+  SDL_Texture *getImageLevel(EffectImage image, int level) {
+    uint32_t key = static_cast<uint32_t>(image * IMAGE_LEVELS + level);
+    return imageCache.getOrCreate(key, [&]() -> SDL_Texture * {
+      if (level == 0) {
+        SDL_Texture *texture = loadImageTexture(EFFECT_IMAGE_PATHS[image]);
+        if (texture) {
+          int w, h;
+          SDL_QueryTexture(texture, nullptr, nullptr, &w, &h);
+          imageSizes[image] = {w, h};
+        }
+        return texture;
+      }
+      SDL_Texture *above = getImageLevel(image, level - 1);
+      return above ? halveTexture(above) : nullptr;
+    });
+  }
 
-    return scaledTexture;
+  // Image drawn at `scale` times its source size: returns the smallest mip
+  // still at least that large, and the destination size in w and h
+  SDL_Texture *getImageTexture(EffectImage image, float scale, int &w,
+                               int &h) {
+    if (imageSizes[image].first == 0 && !getImageLevel(image, 0))
+      return nullptr;
+    auto [srcW, srcH] = imageSizes[image];
+    w = static_cast<int>(srcW * scale);
+    h = static_cast<int>(srcH * scale);
+
+    int level = 0;
+    while (level + 1 < IMAGE_LEVELS && (srcW >> (level + 1)) >= w &&
+           (srcH >> (level + 1)) >= h)
+      ++level;
+    return getImageLevel(image, level);
   }
 
+  // Effect images were made for a 1080 px wide, single-lane layout
+  float effectScale() const { return screenW / 1080.0f / lanes * 0.5f; }
+
   void drawLaneEffect(SDL_Renderer *rnd, std::size_t lane, uint32_t effect) {
-    std::string imagePath;
-    std::string effectText;
+    EffectImage image;
+    const char *effectText;
     SDL_Color textColor = {255, 255, 255, 255};
 
     switch (effect) {
     case PERFECT:
-      imagePath = "res/img/perfect.png";
+      image = IMAGE_PERFECT;
       effectText = "PERFECT!";
       textColor = {0, 255, 0, 255};
       break;
     case GREAT:
-      imagePath = "res/img/great.png";
+      image = IMAGE_GREAT;
       effectText = "GREAT!";
       textColor = {0, 200, 100, 255};
       break;
     case GOOD:
-      imagePath = "res/img/good.png";
+      image = IMAGE_GOOD;
       effectText = "GOOD";
       textColor = {200, 200, 0, 255};
       break;
     case BAD:
-      imagePath = "res/img/bad.png";
+      image = IMAGE_BAD;
       effectText = "BAD";
       textColor = {255, 100, 0, 255};
       break;
     case MISS:
-      imagePath = "res/img/miss.png";
+      image = IMAGE_MISS;
       effectText = "MISS";
       textColor = {255, 0, 0, 255};
       break;
     case HOLD_RELEASED:
-      imagePath = "res/img/hold_released.png";
+      image = IMAGE_HOLD_RELEASED;
       effectText = "HOLD";
       textColor = {100, 255, 100, 255};
       break;
@@ -344,187 +430,351 @@ private:
       return;
     }
 
-    auto it = imageTextureCache.find(imagePath);
-    SDL_Texture *imageTexture = nullptr;
-
-    if (it == imageTextureCache.end()) {
-      imageTexture = loadImageTexture(imagePath.c_str());
-      if (imageTexture) {
-        imageTextureCache[imagePath] = imageTexture;
-      }
-    } else {
-      imageTexture = it->second;
-    }
-
+    int effectWidth, effectHeight;
+    SDL_Texture *imageTexture =
+        getImageTexture(image, effectScale(), effectWidth, effectHeight);
     if (!imageTexture)
       return;
 
-    int effectWidth, effectHeight;
-    SDL_QueryTexture(imageTexture, nullptr, nullptr, &effectWidth,
-                     &effectHeight);
-
     int laneCenterX = lane * laneWidth + laneWidth / 2;
-    int effectY = fragmentHeight * game.fragments * 2 / 3;
+    int effectY = fragmentHeight * fragments * 2 / 3;
 
     SDL_Rect destRect = {laneCenterX - effectWidth / 2,
                          effectY - effectHeight / 2, effectWidth, effectHeight};
 
     SDL_RenderCopy(rnd, imageTexture, nullptr, &destRect);
+    ++current.drawCalls;
 
     drawText(rnd, effectText, laneCenterX, effectY + effectHeight / 2,
              small_font, textColor, ALIGN_CENTER);
   }
 
-  void drawCenterEffect(SDL_Renderer *rnd, uint32_t effect, uint32_t num) {
+  void drawCenterEffect(SDL_Renderer *rnd, uint32_t effect, uint32_t num,
+                        uint32_t combo) {
     if (effect & COMBO) {
-      std::string imagePath = "res/img/combo.png";
-      std::string comboText = std::to_string(game.combo);
+      char text[32];
 
-      auto it = imageTextureCache.find(imagePath);
-      SDL_Texture *imageTexture = nullptr;
-
-      if (it == imageTextureCache.end()) {
-        imageTexture = loadImageTexture(imagePath.c_str());
-        if (imageTexture) {
-          imageTextureCache[imagePath] = imageTexture;
-        }
-      } else {
-        imageTexture = it->second;
-      }
+      int effectWidth, effectHeight;
+      SDL_Texture *imageTexture = getImageTexture(
+          IMAGE_COMBO, effectScale() * 1.5f, effectWidth, effectHeight);
 
       if (imageTexture) {
-        int effectWidth, effectHeight;
-        SDL_QueryTexture(imageTexture, nullptr, nullptr, &effectWidth,
-                         &effectHeight);
-
-        effectWidth = static_cast<int>(effectWidth * 1.5f);
-        effectHeight = static_cast<int>(effectHeight * 1.5f);
-
         SDL_Rect destRect = {screenW / 2 - effectWidth / 2,
                              screenH / 3 - effectHeight / 2, effectWidth,
                              effectHeight};
 
         SDL_RenderCopy(rnd, imageTexture, nullptr, &destRect);
+        ++current.drawCalls;
 
-        SDL_Color comboColor = game.combo >= 50 ? SDL_Color{255, 215, 0, 255}
-                               : game.combo >= 20
+        SDL_Color comboColor = combo >= 50 ? SDL_Color{255, 215, 0, 255}
+                               : combo >= 20
                                    ? SDL_Color{255, 100, 255, 255}
                                    : SDL_Color{255, 255, 255, 255};
 
-        drawText(rnd, comboText, screenW / 2, screenH / 3, large_font,
+        std::snprintf(text, sizeof text, "%u", combo);
+        drawText(rnd, text, screenW / 2, screenH / 3, large_font,
+                 comboColor, ALIGN_CENTER);
+        std::snprintf(text, sizeof text, "COMBO: %u", num);
+        drawText(rnd, text, screenW / 2, screenH / 3 + 80, medium_font,
                  comboColor, ALIGN_CENTER);
-        drawText(rnd, "COMBO: " + std::to_string(num), screenW / 2,
-                 screenH / 3 + 80, medium_font, comboColor, ALIGN_CENTER);
       }
     }
 
     if (effect & SCORE) {
-      std::string imagePath = "res/img/score.png";
+      char text[32];
 
-      auto it = imageTextureCache.find(imagePath);
-      SDL_Texture *imageTexture = nullptr;
-
-      if (it == imageTextureCache.end()) {
-        imageTexture = loadImageTexture(imagePath.c_str());
-        if (imageTexture) {
-          imageTextureCache[imagePath] = imageTexture;
-        }
-      } else {
-        imageTexture = it->second;
-      }
+      int effectWidth, effectHeight;
+      SDL_Texture *imageTexture = getImageTexture(
+          IMAGE_SCORE, effectScale() * 0.5f, effectWidth, effectHeight);
 
       if (imageTexture) {
-        int effectWidth, effectHeight;
-        SDL_QueryTexture(imageTexture, nullptr, nullptr, &effectWidth,
-                         &effectHeight);
-
-        SDL_Rect destRect = {screenW / 2 - effectWidth / 4, 80, effectWidth / 2,
-                             effectHeight / 2};
+        SDL_Rect destRect = {screenW / 2 - effectWidth / 2, 80, effectWidth,
+                             effectHeight};
 
         SDL_RenderCopy(rnd, imageTexture, nullptr, &destRect);
+        ++current.drawCalls;
 
-        drawText(rnd, "SCORE: " + std::to_string(num), screenW / 2, 150,
-                 medium_font, {100, 255, 100, 255}, ALIGN_CENTER);
+        std::snprintf(text, sizeof text, "SCORE: %u", num);
+        drawText(rnd, text, screenW / 2, 150, medium_font,
+                 {100, 255, 100, 255}, ALIGN_CENTER);
       }
     }
   }
 
-  SDL_Texture *createFragmentTexture(SDL_Renderer *rnd, int8_t fragmentValue,
-                                     bool pressed, uint32_t holdPressedTime) {
-    SDL_Texture *texture =
-        SDL_CreateTexture(rnd, SDL_PIXELFORMAT_RGBA8888,
-                          SDL_TEXTUREACCESS_TARGET, laneWidth, fragmentHeight);
-    SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+  void createNotesAtlas() {
+    notesAtlas = SDL_CreateTexture(sdl_renderer, SDL_PIXELFORMAT_RGBA8888,
+                                   SDL_TEXTUREACCESS_TARGET,
+                                   SWATCH_SIZE * SWATCH_COUNT, SWATCH_SIZE);
+    if (!notesAtlas) {
+      std::cerr << "Failed to create notes atlas: " << SDL_GetError()
+                << std::endl;
+      return;
+    }
+    SDL_SetTextureBlendMode(notesAtlas, SDL_BLENDMODE_BLEND);
 
-    SDL_Texture *prevTarget = SDL_GetRenderTarget(rnd);
-    SDL_SetRenderTarget(rnd, texture);
+    SDL_Texture *prevTarget = SDL_GetRenderTarget(sdl_renderer);
+    SDL_SetRenderTarget(sdl_renderer, notesAtlas);
 
-    SDL_SetRenderDrawColor(rnd, 0, 0, 0, 0);
-    SDL_RenderClear(rnd);
+    SDL_SetRenderDrawColor(sdl_renderer, 0, 0, 0, 0);
+    SDL_RenderClear(sdl_renderer);
+
+    const SDL_Color colors[SWATCH_COUNT] = {
+        {80, 80, 180, 80},   // empty
+        {255, 50, 50, 255},  // tap
+        {100, 255, 100, 200}, // hold
+        {255, 255, 255, 255}, // white
+    };
+    for (int i = 0; i < SWATCH_COUNT; ++i) {
+      SDL_SetRenderDrawColor(sdl_renderer, colors[i].r, colors[i].g,
+                             colors[i].b, colors[i].a);
+      SDL_Rect swatchRect = {i * SWATCH_SIZE, 0, SWATCH_SIZE, SWATCH_SIZE};
+      SDL_RenderFillRect(sdl_renderer, &swatchRect);
+    }
+
+    SDL_SetRenderTarget(sdl_renderer, prevTarget);
+  }
 
-    SDL_Color color;
-    if (fragmentValue == -1) {
-      color = {255, 50, 50, 255};
-    } else if (fragmentValue > 0) {
-      if (pressed) {
-        float pulse = 0.7f + 0.3f * sin(holdPressedTime / 100.0f);
-        color = {0, static_cast<Uint8>(150 * pulse), 0, 255};
-      } else {
-        color = {100, 255, 100, 200};
+  void buildStaticLayer() {
+    if (staticLayer)
+      SDL_DestroyTexture(staticLayer);
+    staticLanes = lanes;
+    staticFragments = fragments;
+
+    staticLayer = SDL_CreateTexture(sdl_renderer, SDL_PIXELFORMAT_RGBA8888,
+                                    SDL_TEXTUREACCESS_TARGET, screenW, screenH);
+    ++current.textureCreations;
+    if (!staticLayer) {
+      std::cerr << "Failed to create static layer: " << SDL_GetError()
+                << std::endl;
+      return;
+    }
+    SDL_SetTextureBlendMode(staticLayer, SDL_BLENDMODE_BLEND);
+
+    SDL_Texture *prevTarget = SDL_GetRenderTarget(sdl_renderer);
+    SDL_SetRenderTarget(sdl_renderer, staticLayer);
+
+    SDL_SetRenderDrawColor(sdl_renderer, 0, 0, 0, 0);
+    SDL_RenderClear(sdl_renderer);
+
+    SDL_SetRenderDrawColor(sdl_renderer, 100, 100, 100, 255);
+    for (std::size_t lane = 1; lane < lanes; ++lane) {
+      int x = lane * laneWidth;
+      SDL_RenderDrawLine(sdl_renderer, x, 0, x, screenH);
+    }
+
+    SDL_SetRenderDrawColor(sdl_renderer, 60, 60, 60, 255);
+    for (std::size_t fragment = 1; fragment < fragments; ++fragment) {
+      int y = fragment * fragmentHeight;
+      SDL_RenderDrawLine(sdl_renderer, 0, y, screenW, y);
+    }
+
+    // Lane key hints
+    char text[16];
+    for (std::size_t lane = 0; lane < lanes; ++lane) {
+      int laneCenterX = lane * laneWidth + laneWidth / 2;
+      if (lane < 9)
+        std::snprintf(text, sizeof text, "%c", "ASDFGHJKL"[lane]);
+      else
+        std::snprintf(text, sizeof text, "%zu", lane + 1);
+      drawText(sdl_renderer, text, laneCenterX, screenH - 30, small_font,
+               {200, 200, 200, 255}, ALIGN_CENTER);
+    }
+
+    // Judgement line
+    SDL_SetRenderDrawColor(sdl_renderer, 255, 255, 255, 255);
+    SDL_Rect judgmentLine = {0, screenH - fragmentHeight, screenW, 3};
+    SDL_RenderFillRect(sdl_renderer, &judgmentLine);
+
+    SDL_SetRenderTarget(sdl_renderer, prevTarget);
+  }
+
+  // One bar per recent frame, newest on the right, 50 ms at the top, with
+  // guide lines at 60 and 30 FPS. Below it the lows and the 99th percentile
+  // of each phase, in ms.
+  void drawPacingGraph(SDL_Renderer *rnd, const FramePacer &pacer) {
+    const int graphW = 240, graphH = 80;
+    const int x0 = screenW - 20 - graphW, y0 = 230;
+    const float topMs = 50.0f;
+
+    SDL_SetRenderDrawColor(rnd, 20, 20, 20, 255);
+    SDL_Rect background = {x0, y0, graphW, graphH};
+    SDL_RenderFillRect(rnd, &background);
+
+    pacingBars.clear();
+    std::size_t n = std::min<std::size_t>(pacer.size(), graphW);
+    for (std::size_t i = 0; i < n; ++i) {
+      float ms = std::min(pacer.recentFrame(i), topMs);
+      int h = static_cast<int>(ms / topMs * graphH);
+      pacingBars.push_back(
+          {x0 + graphW - 1 - static_cast<int>(i), y0 + graphH - h, 1, h});
+    }
+    SDL_SetRenderDrawColor(rnd, 100, 200, 255, 255);
+    if (!pacingBars.empty())
+      SDL_RenderFillRects(rnd, pacingBars.data(),
+                          static_cast<int>(pacingBars.size()));
+
+    SDL_SetRenderDrawColor(rnd, 255, 200, 0, 255);
+    for (float ms : {1000.0f / 60, 1000.0f / 30}) {
+      SDL_Rect guide = {x0, y0 + graphH - static_cast<int>(ms / topMs * graphH),
+                        graphW, 1};
+      SDL_RenderFillRect(rnd, &guide);
+    }
+    current.drawCalls += 4;
+
+    char text[64];
+    std::snprintf(text, sizeof text, "1%% low: %.0f  0.1%% low: %.0f",
+                  pacer.lowFps(0.01f), pacer.lowFps(0.001f));
+    drawText(rnd, text, screenW - 20, y0 + graphH + 20, small_font,
+             {200, 200, 200, 255}, ALIGN_RIGHT);
+    std::snprintf(text, sizeof text, "p99 sim %.2f  render %.2f  present %.2f",
+                  pacer.percentileMs(0.01f, PHASE_SIMULATE),
+                  pacer.percentileMs(0.01f, PHASE_RENDER),
+                  pacer.percentileMs(0.01f, PHASE_PRESENT));
+    drawText(rnd, text, screenW - 20, y0 + graphH + 40, small_font,
+             {200, 200, 200, 255}, ALIGN_RIGHT);
+  }
+
+  bool highwayChanged(const ViewState &view) const {
+    std::size_t n = lanes * fragments;
+    return composedCells.size() != n || composedStart != view.highwayStart ||
+           std::memcmp(composedCells.data(), view.cells, n) != 0;
+  }
+
+  // Every cell and hold counter, one highway row per fragment from the top
+  void composeHighway(const ViewState &view) {
+    int layerH = fragments * fragmentHeight;
+    if (!highwayLayer || highwayLayerW != screenW || highwayLayerH != layerH) {
+      if (highwayLayer)
+        SDL_DestroyTexture(highwayLayer);
+      highwayLayer =
+          SDL_CreateTexture(sdl_renderer, SDL_PIXELFORMAT_RGBA8888,
+                            SDL_TEXTUREACCESS_TARGET, screenW, layerH);
+      ++current.textureCreations;
+      if (!highwayLayer) {
+        std::cerr << "Failed to create highway layer: " << SDL_GetError()
+                  << std::endl;
+        return;
       }
-    } else {
-      color = {80, 80, 180, 80};
+      SDL_SetTextureBlendMode(highwayLayer, SDL_BLENDMODE_BLEND);
+      highwayLayerW = screenW;
+      highwayLayerH = layerH;
     }
 
-    SDL_SetRenderDrawColor(rnd, color.r, color.g, color.b, color.a);
-    SDL_Rect fillRect = {1, 1, laneWidth - 2, fragmentHeight - 2};
-    SDL_RenderFillRect(rnd, &fillRect);
+    composedStart = view.highwayStart;
+    composedCells.assign(view.cells, view.cells + lanes * fragments);
 
-    if (fragmentValue > 0) {
-      std::string holdText = std::to_string(fragmentValue);
-      drawText(rnd, holdText, laneWidth / 2, fragmentHeight / 2, small_font,
-               {255, 255, 255, 255}, ALIGN_CENTER);
+    SDL_Texture *prevTarget = SDL_GetRenderTarget(sdl_renderer);
+    SDL_SetRenderTarget(sdl_renderer, highwayLayer);
+    SDL_SetRenderDrawColor(sdl_renderer, 0, 0, 0, 0);
+    SDL_RenderClear(sdl_renderer);
+
+    highwayVertices.clear();
+    highwayIndices.clear();
+    char text[16];
+    for (std::size_t fragmentIdx = 0; fragmentIdx < fragments;
+         ++fragmentIdx) {
+      const int8_t *row = view.row(fragmentIdx);
+      int y = fragmentIdx * fragmentHeight;
+
+      for (std::size_t lane = 0; lane < lanes; ++lane) {
+        int8_t fragmentValue = row[lane];
+        NoteSwatch swatch = fragmentValue == -1 ? SWATCH_TAP
+                            : fragmentValue > 0 ? SWATCH_HOLD
+                                                : SWATCH_EMPTY;
+        pushQuad(lane * laneWidth + 1, y + 1, laneWidth - 2,
+                 fragmentHeight - 2, swatch, {255, 255, 255, 255});
+
+        if (fragmentValue > 0) {
+          std::snprintf(text, sizeof text, "%d", fragmentValue);
+          queueText(sdl_renderer, text, lane * laneWidth + laneWidth / 2,
+                    y + fragmentHeight / 2, {255, 255, 255, 255},
+                    ALIGN_CENTER);
+        }
+      }
     }
 
-    SDL_SetRenderTarget(rnd, prevTarget);
+    // Swatches are copied as is, so translucent cells are not blended
+    // twice when the layer itself is drawn
+    SDL_SetTextureBlendMode(notesAtlas, SDL_BLENDMODE_NONE);
+    current.drawCalls += submitQuads(sdl_renderer);
+    SDL_SetTextureBlendMode(notesAtlas, SDL_BLENDMODE_BLEND);
+    current.drawCalls += smallGlyphs.flush(sdl_renderer);
 
-    return texture;
+    SDL_SetRenderTarget(sdl_renderer, prevTarget);
+  }
+
+  int submitQuads(SDL_Renderer *rnd) {
+    if (highwayVertices.empty())
+      return 0;
+    SDL_RenderGeometry(rnd, notesAtlas, highwayVertices.data(),
+                       static_cast<int>(highwayVertices.size()),
+                       highwayIndices.data(),
+                       static_cast<int>(highwayIndices.size()));
+    return 1;
+  }
+
+  void pushQuad(float x, float y, float w, float h, NoteSwatch swatch,
+                SDL_Color color) {
+    // Every corner samples the swatch centre, so filtering never bleeds in
+    // neighbours
+    SDL_FPoint uv = {(2 * swatch + 1) / (2.0f * int(SWATCH_COUNT)), 0.5f};
+    float x0 = x, y0 = y, x1 = x + w, y1 = y + h;
+    int base = static_cast<int>(highwayVertices.size());
+
+    highwayVertices.push_back({{x0, y0}, color, uv});
+    highwayVertices.push_back({{x1, y0}, color, uv});
+    highwayVertices.push_back({{x1, y1}, color, uv});
+    highwayVertices.push_back({{x0, y1}, color, uv});
+    for (int i : {0, 1, 2, 0, 2, 3})
+      highwayIndices.push_back(base + i);
   }
 
   SDL_Texture *getTextTexture(SDL_Renderer *rnd, const std::string &text,
                               TTF_Font *font, SDL_Color color) {
     std::string cacheKey =
-        text + "_" + std::to_string(color.r) + "_" + std::to_string(color.g) +
+        text + "_" + std::to_string(TTF_FontHeight(font)) + "_" +
+        std::to_string(color.r) + "_" + std::to_string(color.g) +
         "_" + std::to_string(color.b) + "_" + std::to_string(color.a);
 
-    auto it = textTextureCache.find(cacheKey);
-    if (it != textTextureCache.end()) {
-      return it->second;
-    }
-
-    SDL_Surface *textSurface =
-        TTF_RenderText_Blended(font, text.c_str(), color);
-    if (!textSurface) {
-      std::cerr << "TTF_RenderText error: " << TTF_GetError() << std::endl;
-      return nullptr;
-    }
-
-    SDL_Texture *texture = SDL_CreateTextureFromSurface(rnd, textSurface);
-    SDL_FreeSurface(textSurface);
+    return textCache.getOrCreate(cacheKey, [&]() -> SDL_Texture * {
+      SDL_Surface *textSurface =
+          TTF_RenderText_Blended(font, text.c_str(), color);
+      if (!textSurface) {
+        std::cerr << "TTF_RenderText error: " << TTF_GetError() << std::endl;
+        return nullptr;
+      }
 
-    if (texture) {
-      textTextureCache[cacheKey] = texture;
-    }
+      SDL_Texture *texture = SDL_CreateTextureFromSurface(rnd, textSurface);
+      SDL_FreeSurface(textSurface);
+      ++current.textureCreations;
+      return texture;
+    });
+  }
 
-    return texture;
+  GlyphAtlas *glyphsFor(TTF_Font *font) {
+    if (font == large_font)
+      return &largeGlyphs;
+    if (font == medium_font)
+      return &mediumGlyphs;
+    if (font == small_font)
+      return &smallGlyphs;
+    return nullptr;
   }
 
-  void drawText(SDL_Renderer *rnd, const std::string &text, int x, int y,
+  void drawText(SDL_Renderer *rnd, std::string_view text, int x, int y,
                 TTF_Font *font, SDL_Color color, Alignment align = ALIGN_LEFT) {
     if (text.empty())
       return;
 
-    SDL_Texture *textTexture = getTextTexture(rnd, text, font, color);
+    GlyphAtlas *glyphs = glyphsFor(font);
+    if (glyphs && glyphs->canDraw(text)) {
+      glyphs->append(text, x, y, color, align);
+      current.drawCalls += glyphs->flush(rnd);
+      return;
+    }
+
+    SDL_Texture *textTexture =
+        getTextTexture(rnd, std::string(text), font, color);
     if (!textTexture)
       return;
 
@@ -550,5 +800,15 @@ private:
     destRect.h = textHeight;
 
     SDL_RenderCopy(rnd, textTexture, nullptr, &destRect);
+    ++current.drawCalls;
+  }
+
+  // Small-font text batched until the next smallGlyphs.flush()
+  void queueText(SDL_Renderer *rnd, std::string_view text, int x, int y,
+                 SDL_Color color, Alignment align) {
+    if (smallGlyphs.canDraw(text))
+      smallGlyphs.append(text, x, y, color, align);
+    else
+      drawText(rnd, text, x, y, small_font, color, align);
   }
 };
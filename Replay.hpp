@@ -0,0 +1,139 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+
+#include "include/vector.hpp"
+
+#include "Game.hpp"
+#include "InputEvent.hpp"
+#include "Scheduler.hpp"
+
+// Recorded input stream of one session, plus the settings needed to rebuild
+// the Game it was played against.
+//
+// File format (same "&key=value" header style as the chart files):
+//   &lanes=4
+//   &fragments=10
+//   &mpf=145           (0: variable tempo, timing comes from the chart)
+//   <timeMs> <lane> <d|u>
+class InputLog {
+public:
+  std::size_t lanes = 0;
+  std::size_t fragments = 0;
+  uint32_t msPerFragment = 0;
+  mystd::vector<InputEvent> events; // sorted by timeMs
+
+  void reset(std::size_t lanes_, std::size_t fragments_, uint32_t mpf) {
+    lanes = lanes_;
+    fragments = fragments_;
+    msPerFragment = mpf;
+    events.clear();
+  }
+
+  // Events arrive in time order from the event loop, so no sorting is needed
+  inline void record(uint32_t timeMs, std::size_t lane, bool pressed) {
+    events.push_back({timeMs, static_cast<uint32_t>(lane), pressed});
+  }
+
+  bool save(const std::string &filepath) const {
+    std::ofstream file(filepath);
+    if (!file.is_open()) {
+      std::cerr << "[ERROR] Cannot write input log: " << filepath << std::endl;
+      return false;
+    }
+
+    file << "&lanes=" << lanes << '\n';
+    file << "&fragments=" << fragments << '\n';
+    file << "&mpf=" << msPerFragment << '\n';
+    for (const InputEvent &e : events)
+      file << e.timeMs << ' ' << e.lane << ' ' << (e.pressed ? 'd' : 'u')
+           << '\n';
+    return true;
+  }
+
+  bool load(const std::string &filepath) {
+    std::ifstream file(filepath);
+    if (!file.is_open()) {
+      std::cerr << "[ERROR] Cannot open input log: " << filepath << std::endl;
+      return false;
+    }
+
+    events.clear();
+    std::string line;
+    while (std::getline(file, line)) {
+      if (line.empty() || line[0] == '#')
+        continue;
+
+      if (line.find("&lanes=") == 0) {
+        lanes = std::stoul(line.substr(7));
+      } else if (line.find("&fragments=") == 0) {
+        fragments = std::stoul(line.substr(11));
+      } else if (line.find("&mpf=") == 0) {
+        msPerFragment = std::stoul(line.substr(5));
+      } else {
+        InputEvent e;
+        char type;
+        if (std::sscanf(line.c_str(), "%u %u %c", &e.timeMs, &e.lane, &type) !=
+            3) {
+          std::cerr << "[WARNING] Invalid input log line: " << line
+                    << std::endl;
+          continue;
+        }
+        e.pressed = type == 'd';
+        events.push_back(e);
+      }
+    }
+    return true;
+  }
+};
+
+// Number of fragments after which every note of the chart has scrolled past
+// the judgement line
+inline std::size_t chartLength(const Game &game) {
+  std::size_t length = 0;
+  for (const KeyNoteData &n : game.notes) {
+    std::size_t end = n.startFragment + (n.holds > 0 ? n.holds : 1);
+    length = std::max(length, end);
+  }
+  return length + game.fragments + 1;
+}
+
+// Reads an InputLog in order, as an InputSource for FragmentScheduler
+class InputLogCursor {
+  const InputLog &log;
+  std::size_t next = 0;
+
+public:
+  // Starts at the first event at or after `fromMs`
+  explicit InputLogCursor(const InputLog &log_, uint32_t fromMs = 0)
+      : log(log_) {
+    while (next < log.events.size() && log.events[next].timeMs < fromMs)
+      ++next;
+  }
+
+  const InputEvent *front() const {
+    return next < log.events.size() ? &log.events[next] : nullptr;
+  }
+  void pop() { ++next; }
+};
+
+// Headless replay: drives `game` with `log` on a virtual clock instead of
+// SDL_GetTicks(), through the same FragmentScheduler as RhythmQuest.cpp's main
+// loop. Runs as fast as the CPU allows and stops once `game.nowFragment`
+// reaches `totalFragments`. Can resume a game (e.g. a restored snapshot):
+// events before its current fragment are skipped.
+inline void simulate(Game &game, const InputLog &log,
+                     std::size_t totalFragments,
+                     std::function<void(Game &)> foo = nullptr,
+                     std::function<void(Game &)> bar = nullptr) {
+  InputLogCursor cursor(log, game.fragmentMs(game.nowFragment));
+  FragmentScheduler scheduler;
+  scheduler.advance(game, game.fragmentMs(totalFragments), cursor, foo, bar);
+}
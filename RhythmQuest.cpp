@@ -5,19 +5,29 @@
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_image.h>
 #include <SDL2/SDL_ttf.h>
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
+#include <cstdio>
+#include <filesystem>
 #include <functional>
 #include <iostream>
+#include <thread>
 
 #include "include/vector.hpp"
 
 #include "KeyNoteData.hpp"
 #include "Game.hpp"
+#include "InputQueue.hpp"
 #include "Mods.hpp"
 #include "Renderer.hpp"
-#include "ChartParser.hpp"
+#include "ChartLibrary.hpp"
+#include "CompiledChart.hpp"
+#include "FramePacer.hpp"
 #include "MusicManager.hpp"
+#include "Replay.hpp"
+#include "Scheduler.hpp"
+#include "ViewState.hpp"
 #include "mods/GameOfLife.hpp"
 
 TTF_Font *large_font, *medium_font, *small_font;
@@ -26,22 +36,197 @@ int SCREEN_HEIGHT = 768;
 
 std::size_t LANES = 4;
 std::size_t FRAGMENTS = 10;
-uint32_t MS_PER_FRAGMENT = 200;
 std::string MOD;
 SettingsFunc modSettingsFunc;
-mystd::vector<KeyNoteData> keyNotes;
 
 Game *game = static_cast<Game *>(::operator new(sizeof(Game)));
 Renderer *gameRenderer =
     static_cast<Renderer *>(::operator new(sizeof(Renderer)));
-ChartParser *chartParser = new ChartParser(keyNotes);
+CompiledChart chart;
+ChartLibrary library;
+std::size_t selectedChart = 0;
 MusicManager *musicManager = new MusicManager();
+InputLog inputLog;
+InputQueue inputQueue;
+std::atomic<bool> captureInput{false};
+std::atomic<Uint32> gameStartTime{0};
+FragmentScheduler scheduler;
+ViewBuffer viewBuffer;
+std::atomic<bool> simRunning{false};
+std::thread simThread;
+FramePacer pacer;
+bool pacingSaved = true;
+bool songPlaying = false;
+
+// InputSource for the scheduler that records every judged key into inputLog
+struct RecordedInputQueue {
+  const InputEvent *front() const { return inputQueue.front(); }
+  void pop() {
+    const InputEvent *e = inputQueue.front();
+    inputLog.record(e->timeMs, e->lane, e->pressed);
+    inputQueue.pop();
+  }
+};
+
+// Simulation thread, runs only in GameState::GAME. It owns *game, scheduler
+// and inputLog while running and publishes a ViewState every tick; the main
+// thread only draws the latest view, so render and present never delay
+// judging or fragment loading.
+void simulationLoop(ModFunc foo, ModFunc bar) {
+  while (simRunning.load(std::memory_order_acquire)) {
+    // Game time follows the audio clock while the song plays. Re-anchoring
+    // gameStartTime on it keeps captured key timestamps on the same clock.
+    uint32_t nowMs =
+        SDL_GetTicks() - gameStartTime.load(std::memory_order_relaxed);
+    if (musicManager->isMusicPlaying()) {
+      nowMs = musicManager->getMusicTime();
+      gameStartTime.store(SDL_GetTicks() - nowMs, std::memory_order_relaxed);
+    }
+
+    // Judge captured keys and load every due fragment in time order
+    uint64_t tickStart = SDL_GetPerformanceCounter();
+    RecordedInputQueue inputs;
+    std::size_t loaded = scheduler.advance(*game, nowMs, inputs, foo, bar);
+    if (loaded > 1)
+      std::cerr << "[WARNING] Simulation fell behind, caught up " << loaded
+                << " fragments at fragment " << game->nowFragment
+                << std::endl;
+
+    ViewState &view = viewBuffer.back();
+    saveView(*game, nowMs, view);
+    view.simulateMs = (SDL_GetPerformanceCounter() - tickStart) * 1000.0f /
+                      SDL_GetPerformanceFrequency();
+    viewBuffer.publish();
+
+    SDL_Delay(1);
+  }
+}
+
+void startSimulation() {
+  if (simRunning.load(std::memory_order_relaxed))
+    return;
+  uint32_t nowMs =
+      SDL_GetTicks() - gameStartTime.load(std::memory_order_relaxed);
+  saveView(*game, nowMs, viewBuffer.back());
+  viewBuffer.publish();
+
+  simRunning.store(true, std::memory_order_release);
+  simThread = std::thread(simulationLoop, mystd::get<0>(getModMap()[MOD]),
+                          mystd::get<1>(getModMap()[MOD]));
+}
+
+void stopSimulation() {
+  simRunning.store(false, std::memory_order_release);
+  if (simThread.joinable())
+    simThread.join();
+}
+
+// Frame pacing of the last song, written once it ends
+void savePacing() {
+  if (!pacingSaved && pacer.recorded() > 0) {
+    pacer.writeCsv("frame_pacing.csv");
+    pacer.writeSummaryCsv("frame_pacing_summary.csv");
+  }
+  pacingSaved = true;
+}
+
+// Frames are paced here instead of by vsync, so the main thread never blocks
+// in SDL_RenderPresent and can pump events while it waits for the next frame.
+uint64_t frameTicks = 0;
+uint64_t nextFrame = 0;
+
+void setRefreshRate(SDL_Window *window) {
+  SDL_DisplayMode mode;
+  int hz = 60;
+  if (SDL_GetWindowDisplayMode(window, &mode) == 0 && mode.refresh_rate > 0)
+    hz = mode.refresh_rate;
+  frameTicks = SDL_GetPerformanceFrequency() / hz;
+  nextFrame = 0;
+}
+
+// Waits for the next frame slot, calling SDL_PumpEvents about every 1 ms.
+// captureKeyEvent runs inside the pump, so keys pressed while waiting are
+// stamped within ~1 ms. Keys pressed during render wait for the next pump.
+void waitNextFrame() {
+  uint64_t oneMs = SDL_GetPerformanceFrequency() / 1000;
+  uint64_t now = SDL_GetPerformanceCounter();
+  nextFrame += frameTicks;
+  if (nextFrame + frameTicks < now)
+    nextFrame = now + frameTicks;  // fell behind, don't burst frames
+
+  while (true) {
+    SDL_PumpEvents();
+    now = SDL_GetPerformanceCounter();
+    if (now >= nextFrame)
+      break;
+    if (nextFrame - now > oneMs)
+      SDL_Delay(1);
+    else
+      std::this_thread::yield();
+  }
+}
+
+void presentFrame(SDL_Renderer *renderer) {
+  SDL_RenderPresent(renderer);
+  waitNextFrame();
+}
 
 enum class GameState { SETTINGS, COUNTDOWN, GAME, PAUSE };
 
 GameState currentState;
 bool running = true;
 
+std::size_t laneOfKey(SDL_Keycode key) {
+  switch (key) {
+  case SDLK_a:
+    return 0;
+  case SDLK_s:
+    return 1;
+  case SDLK_d:
+    return 2;
+  case SDLK_f:
+    return 3;
+  case SDLK_g:
+    return 4;
+  case SDLK_h:
+    return 5;
+  case SDLK_j:
+    return 6;
+  case SDLK_k:
+    return 7;
+  case SDLK_l:
+    return 8;
+  default:
+    return -1;
+  }
+}
+
+// Event watch, runs as SDL queues each event (before SDL_PollEvent hands it
+// to the main loop). Lane keys are stamped with event.key.timestamp and handed
+// to the game through inputQueue. SDL2 takes that timestamp when the event is
+// pumped, so it is only as fresh as the last pump: waitNextFrame() pumps about
+// every 1 ms between frames, render time itself is not pumped.
+int captureKeyEvent(void *, SDL_Event *event) {
+  if (!captureInput.load(std::memory_order_acquire))
+    return 1;
+  if (event->type != SDL_KEYDOWN && event->type != SDL_KEYUP)
+    return 1;
+  if (event->key.repeat)
+    return 1;
+
+  std::size_t lane = laneOfKey(event->key.keysym.sym);
+  if (lane >= LANES)
+    return 1;
+
+  Uint32 startTime = gameStartTime.load(std::memory_order_relaxed);
+  Uint32 timestamp = event->key.timestamp;
+  uint32_t nowMs = timestamp > startTime ? timestamp - startTime : 0;
+  if (!inputQueue.push({nowMs, static_cast<uint32_t>(lane),
+                        event->type == SDL_KEYDOWN}))
+    std::cerr << "[WARNING] Input queue full, key event dropped" << std::endl;
+  return 1;
+}
+
 void renderText(SDL_Renderer *rnd, TTF_Font *font, const std::string &text,
                 int x, int y, SDL_Color color, Alignment align = ALIGN_CENTER) {
   if (text.empty())
@@ -108,6 +293,37 @@ bool pointInRect(int x, int y, SDL_Rect rect) {
          y < rect.y + rect.h;
 }
 
+// Game indexes the notes on construction, so this runs before it is built
+void loadSelectedChart() {
+  std::string path = library.empty() ? "./chart/test_chart.txt"
+                                     : library[selectedChart].path;
+  // 載入譜面
+  // Compiled on first use, then mapped from ./chart/.cache
+  if (chart.load(path)) {
+    std::cout << "[OK] Chart loaded successfully" << std::endl;
+    
+    // 取得音符資料
+    mystd::span<const MouseNoteData> mouseNotes = chart.getMouseNotes();
+    
+    std::cout << "[INFO] Key notes: " << chart.getKeyNotes().size() << std::endl;
+    std::cout << "[INFO] Mouse notes: " << mouseNotes.size() << std::endl;
+    
+    // 載入音樂
+    musicManager->loadMusic(chart.getMusicFile());
+  } else {
+    std::cerr << "[ERROR] Failed to load chart" << std::endl;
+  }
+}
+
+// "name  120 BPM  2:05" for the settings screen
+std::string chartLabel(const ChartInfo &info) {
+  char details[48];
+  uint32_t seconds = info.durationMs / 1000;
+  std::snprintf(details, sizeof details, "  %d BPM  %u:%02u", info.bpm,
+                seconds / 60, seconds % 60);
+  return std::filesystem::path(info.path).stem().string() + details;
+}
+
 void showSettings(SDL_Renderer *renderer) {
   bool running = true;
   SDL_Event e;
@@ -116,6 +332,8 @@ void showSettings(SDL_Renderer *renderer) {
   SDL_Color grey = {100, 100, 100, 255};
   SDL_Color blue = {0, 128, 255, 255};
 
+  SDL_Rect chartPrev = {310, 20, 40, 40};
+  SDL_Rect chartNext = {SCREEN_WIDTH - 90, 20, 40, 40};
   SDL_Rect lanesMinus = {310, 80, 40, 40};
   SDL_Rect lanesPlus = {410, 80, 40, 40};
   SDL_Rect fragmentsMinus = {310, 140, 40, 40};
@@ -137,7 +355,14 @@ void showSettings(SDL_Renderer *renderer) {
 
       if (e.type == SDL_MOUSEBUTTONDOWN && e.button.button == SDL_BUTTON_LEFT) {
         int mx = e.button.x, my = e.button.y;
-        if (pointInRect(mx, my, lanesMinus)) {
+        if (pointInRect(mx, my, chartPrev)) {
+          if (!library.empty())
+            selectedChart =
+                (selectedChart + library.size() - 1) % library.size();
+        } else if (pointInRect(mx, my, chartNext)) {
+          if (!library.empty())
+            selectedChart = (selectedChart + 1) % library.size();
+        } else if (pointInRect(mx, my, lanesMinus)) {
           if (LANES > 1)
             --LANES;
         } else if (pointInRect(mx, my, lanesPlus)) {
@@ -172,6 +397,7 @@ void showSettings(SDL_Renderer *renderer) {
     SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
     SDL_RenderClear(renderer);
 
+    renderText(renderer, medium_font, "CHART:", 50, 40, white, ALIGN_LEFT);
     renderText(renderer, medium_font, "LANES:", 50, 100, white, ALIGN_LEFT);
     renderText(renderer, medium_font, "FRAGMENTS:", 50, 160, white, ALIGN_LEFT);
     renderText(renderer, medium_font, "MOD:", 50, 220, white, ALIGN_LEFT);
@@ -180,7 +406,13 @@ void showSettings(SDL_Renderer *renderer) {
     renderText(renderer, medium_font, std::to_string(FRAGMENTS), 380, 165,
                white);
     renderText(renderer, medium_font, MOD, 310, 220, white, ALIGN_LEFT);
+    renderText(renderer, small_font,
+               library.empty() ? "./chart/test_chart.txt"
+                               : chartLabel(library[selectedChart]),
+               chartPrev.x + 50, 40, white, ALIGN_LEFT);
 
+    renderRoundedRect(renderer, chartPrev, 10, blue);
+    renderRoundedRect(renderer, chartNext, 10, blue);
     renderRoundedRect(renderer, lanesMinus, 10, blue);
     renderRoundedRect(renderer, lanesPlus, 10, blue);
     renderRoundedRect(renderer, fragmentsMinus, 10, blue);
@@ -188,6 +420,10 @@ void showSettings(SDL_Renderer *renderer) {
     renderRoundedRect(renderer, modDropdown, 10, grey);
     renderRoundedRect(renderer, okButton, 15, blue);
 
+    renderText(renderer, medium_font, "<", chartPrev.x + 20, chartPrev.y + 20,
+               white);
+    renderText(renderer, medium_font, ">", chartNext.x + 20, chartNext.y + 20,
+               white);
     renderText(renderer, medium_font, "-", lanesMinus.x + 20, lanesMinus.y + 20,
                white);
     renderText(renderer, medium_font, "+", lanesPlus.x + 20, lanesPlus.y + 20,
@@ -207,16 +443,16 @@ void showSettings(SDL_Renderer *renderer) {
       }
     }
 
-    SDL_RenderPresent(renderer);
+    presentFrame(renderer);
   }
 
   SettingsFunc modSettingsFunc = mystd::get<2>(getModMap()[MOD]);
-  double beatDuration = 60000.0 / chartParser->getBPM();
-  MS_PER_FRAGMENT = beatDuration / chartParser->getFragmentsPerBeat();
-  new (game) Game(LANES, FRAGMENTS, MS_PER_FRAGMENT, keyNotes);
+  loadSelectedChart();
+  new (game)
+      Game(LANES, FRAGMENTS, chart.getTimingMap(), chart.getKeyNotes());
   // game->notes = generateRandomNotes(LANES, 500, 500, 70);
-  new (gameRenderer) Renderer(*game, SCREEN_WIDTH, SCREEN_HEIGHT, renderer,
-                              large_font, medium_font, small_font);
+  new (gameRenderer) Renderer(LANES, FRAGMENTS, SCREEN_WIDTH, SCREEN_HEIGHT,
+                              renderer, large_font, medium_font, small_font);
 
   if (modSettingsFunc) {
     modSettingsFunc(renderer, small_font, SCREEN_WIDTH, SCREEN_HEIGHT);
@@ -274,13 +510,15 @@ void showPauseMenu(SDL_Renderer *renderer) {
     renderText(renderer, medium_font, "Exit Game", exitButton.x + 45,
                exitButton.y + 15, white);
 
-    SDL_RenderPresent(renderer);
+    presentFrame(renderer);
   }
 
   if (choice == 1) {
-    return;
+    currentState = GameState::GAME;
+    musicManager->resumeMusic();
   } else if (choice == 2) {
     currentState = GameState::SETTINGS;
+    musicManager->stopMusic();
   } else if (choice == 3) {
     running = false;
   }
@@ -339,7 +577,7 @@ void showCountdown(SDL_Renderer *renderer) {
                  goRect.y + goRect.h + 35, white);
     }
 
-    SDL_RenderPresent(renderer);
+    presentFrame(renderer);
   }
 
   SDL_DestroyTexture(goTexture);
@@ -379,6 +617,14 @@ int main(int argc, char *argv[]) {
     return 1;
   }
 
+  // Song select reads only this index until a chart file changes
+  LibraryScanStats scanned =
+      library.scan("./chart", "./chart/.cache/library.idx");
+  std::cout << "[OK] Chart library: " << scanned.charts << " charts ("
+            << scanned.parsed << " parsed, " << scanned.reused
+            << " from index) in " << scanned.ms << " ms" << std::endl;
+  selectedChart = library.find("./chart/test_chart.txt");
+
   SDL_Window *window = SDL_CreateWindow(
       "Rhythm Quest", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
       SCREEN_WIDTH, SCREEN_HEIGHT, SDL_WINDOW_SHOWN | SDL_WINDOW_RESIZABLE);
@@ -393,11 +639,9 @@ int main(int argc, char *argv[]) {
     return 1;
   }
 
-  SDL_Renderer *renderer = SDL_CreateRenderer(
-      window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
-
-    
-      
+  // No vsync: waitNextFrame() paces frames and pumps input meanwhile
+  SDL_Renderer *renderer =
+      SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
 
   if (!renderer) {
     std::cerr << "Renderer could not be created: " << SDL_GetError()
@@ -412,11 +656,12 @@ int main(int argc, char *argv[]) {
     return 1;
   }
 
+  setRefreshRate(window);
   currentState = GameState::SETTINGS;
-  Uint32 currentTime = 0, lastFragmentTime = 0, gameStartTime = 0;
+  SDL_AddEventWatch(captureKeyEvent, nullptr);
 
   while (running) {
-    currentTime = SDL_GetTicks();
+    pacer.beginFrame();
 
     SDL_Event event;
     while (SDL_PollEvent(&event)) {
@@ -446,85 +691,15 @@ int main(int argc, char *argv[]) {
         break;
 
       case GameState::GAME:
+        // Lane keys are captured by captureKeyEvent
         if (event.type == SDL_KEYDOWN) {
+          // Pausing the music also stops its sample-counted clock
           if (event.key.keysym.sym == SDLK_ESCAPE) {
             currentState = GameState::PAUSE;
+            musicManager->pauseMusic();
           } else if (event.key.keysym.sym == SDLK_p) {
             currentState = GameState::PAUSE;
-          } else {
-            std::size_t lane = -1;
-            switch (event.key.keysym.sym) {
-            case SDLK_a:
-              lane = 0;
-              break;
-            case SDLK_s:
-              lane = 1;
-              break;
-            case SDLK_d:
-              lane = 2;
-              break;
-            case SDLK_f:
-              lane = 3;
-              break;
-            case SDLK_g:
-              lane = 4;
-              break;
-            case SDLK_h:
-              lane = 5;
-              break;
-            case SDLK_j:
-              lane = 6;
-              break;
-            case SDLK_k:
-              lane = 7;
-              break;
-            case SDLK_l:
-              lane = 8;
-              break;
-            default:
-              break;
-            }
-
-            if (lane < LANES) {
-              game->keyPressed(lane, SDL_GetTicks() - gameStartTime);
-            }
-          }
-        } else if (event.type == SDL_KEYUP) {
-          std::size_t lane = -1;
-          switch (event.key.keysym.sym) {
-          case SDLK_a:
-            lane = 0;
-            break;
-          case SDLK_s:
-            lane = 1;
-            break;
-          case SDLK_d:
-            lane = 2;
-            break;
-          case SDLK_f:
-            lane = 3;
-            break;
-          case SDLK_g:
-            lane = 4;
-            break;
-          case SDLK_h:
-            lane = 5;
-            break;
-          case SDLK_j:
-            lane = 6;
-            break;
-          case SDLK_k:
-            lane = 7;
-            break;
-          case SDLK_l:
-            lane = 8;
-            break;
-          default:
-            break;
-          }
-
-          if (lane < LANES) {
-            game->keyReleased(lane, SDL_GetTicks() - gameStartTime);
+            musicManager->pauseMusic();
           }
         }
         break;
@@ -536,56 +711,64 @@ int main(int argc, char *argv[]) {
           } else if (event.key.keysym.sym == SDLK_p ||
                      event.key.keysym.sym == SDLK_RETURN) {
             currentState = GameState::GAME;
+            musicManager->resumeMusic();
           } else if (event.key.keysym.sym == SDLK_s) {
             currentState = GameState::SETTINGS;
+            musicManager->stopMusic();
           }
         }
         break;
       }
     }
-
+    captureInput.store(currentState == GameState::GAME,
+                       std::memory_order_release);
+    if (currentState == GameState::GAME)
+      startSimulation();
+    else
+      stopSimulation();
+
+    bool recordFrame = currentState == GameState::GAME;
     switch (currentState) {
     case GameState::SETTINGS:
+      savePacing();
+      if (!inputLog.events.empty())
+        inputLog.save("last_replay.txt");
+      // Loads the chart picked there
       showSettings(renderer);
-      // 載入譜面
-      if (chartParser->load("./chart/test_chart.txt")) {
-        std::cout << "[OK] Chart loaded successfully" << std::endl;
-        
-        // 取得音符資料
-        const std::vector<MouseNoteData>& mouseNotes = chartParser->getMouseNotes();
-        
-        std::cout << "[INFO] Key notes: " << keyNotes.size() << std::endl;
-        std::cout << "[INFO] Mouse notes: " << mouseNotes.size() << std::endl;
-        
-        // 載入音樂
-        musicManager->loadMusic(chartParser->getMusicFile());
-      } else {
-        std::cerr << "[ERROR] Failed to load chart" << std::endl;
-      }
       currentState = GameState::COUNTDOWN;
       break;
 
     case GameState::COUNTDOWN:
       showCountdown(renderer);
-      gameStartTime = SDL_GetTicks();
-      lastFragmentTime = gameStartTime;
+      gameStartTime.store(SDL_GetTicks(), std::memory_order_relaxed);
+      scheduler = FragmentScheduler();
+      inputLog.reset(LANES, FRAGMENTS, game->timing.uniformMs());
       musicManager->playMusic(0);  // 加這行：播放音樂一次
+      songPlaying = musicManager->isMusicPlaying();
+      pacer.reset();
+      pacingSaved = false;
       currentState = GameState::GAME;
+      // Drop keys left over from the last game; the simulation is stopped
+      for (InputEvent stale; inputQueue.pop(stale);) {
+      }
+      captureInput.store(true, std::memory_order_release);
       break;
 
     case GameState::GAME: {
-      game->clearExpiredEffects(currentTime - gameStartTime);
-
-      uint32_t offsetMs = currentTime - lastFragmentTime;
-
-      if (offsetMs >= MS_PER_FRAGMENT) {
-        game->loadFragment(mystd::get<0>(getModMap()[MOD]),
-                           mystd::get<1>(getModMap()[MOD]));
-        lastFragmentTime += MS_PER_FRAGMENT;
-        offsetMs = 0;
+      viewBuffer.update();
+      const ViewState &view = viewBuffer.front();
+      pacer.setSimulate(view.simulateMs);
+      pacer.startLap();
+      gameRenderer->render(
+          renderer, view,
+          SDL_GetTicks() - gameStartTime.load(std::memory_order_relaxed),
+          &pacer);
+      pacer.endRender();
+
+      if (songPlaying && !musicManager->isMusicPlaying()) {
+        songPlaying = false;
+        savePacing();
       }
-      gameRenderer->render(renderer, offsetMs);
-
       break;
     }
 
@@ -594,15 +777,27 @@ int main(int argc, char *argv[]) {
       break;
     }
 
+    pacer.startLap();
     SDL_RenderPresent(renderer);
+    pacer.endPresent();
+    waitNextFrame();
 
-    Uint32 tmpTime = SDL_GetTicks();
-    gameRenderer->fps = 1000.0f / (float)(tmpTime - currentTime);
+    if (recordFrame) {
+      pacer.endFrame();
+      gameRenderer->fps = pacer.fps();
+    }
   }
 
+  stopSimulation();
+  savePacing();
+  if (!inputLog.events.empty())
+    inputLog.save("last_replay.txt");
+
+  SDL_DelEventWatch(captureKeyEvent, nullptr);
+
+  gameRenderer->dumpCacheStats("texture_cache_stats.txt");
   delete gameRenderer;
   delete game;
-  delete chartParser;
   delete musicManager;
   SDL_DestroyRenderer(renderer);
   SDL_DestroyWindow(window);
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+#include "Game.hpp"
+
+// Fixed-timestep driver for Game. The k-th loadFragment() belongs to game time
+// game.fragmentMs(k + 1), so every fragment that is due gets processed no
+// matter how long a frame took, and queued inputs are judged in time order in
+// between. Rendering only ever reads offsetMs(), never moves gameplay.
+//
+// InputSource: `const InputEvent *front()` (nullptr when empty) and `pop()`,
+// e.g. InputQueue or an InputLog cursor.
+class FragmentScheduler {
+public:
+  std::size_t lastLoaded = 0;    // fragments loaded by the last advance()
+  std::size_t maxLoaded = 0;     // worst single advance()
+  std::size_t catchUpFrames = 0; // advance() calls that loaded more than one
+
+  template <class InputSource>
+  std::size_t advance(Game &game, uint32_t nowMs, InputSource &inputs,
+                      std::function<void(Game &)> foo = nullptr,
+                      std::function<void(Game &)> bar = nullptr) {
+    std::size_t loaded = 0;
+
+    while (true) {
+      uint32_t fragmentEndMs = game.fragmentMs(game.nowFragment + 1);
+
+      for (auto *e = inputs.front();
+           e && e->timeMs < fragmentEndMs && e->timeMs < nowMs;
+           e = inputs.front()) {
+        if (e->lane < game.lanes) {
+          game.clearExpiredEffects(e->timeMs);
+          if (e->pressed)
+            game.keyPressed(e->lane, e->timeMs);
+          else
+            game.keyReleased(e->lane, e->timeMs);
+        }
+        inputs.pop();
+      }
+
+      if (fragmentEndMs > nowMs)
+        break;
+
+      game.clearExpiredEffects(fragmentEndMs);
+      game.loadFragment(foo, bar);
+      ++loaded;
+    }
+    game.clearExpiredEffects(nowMs);
+
+    lastLoaded = loaded;
+    if (loaded > maxLoaded)
+      maxLoaded = loaded;
+    if (loaded > 1)
+      ++catchUpFrames;
+    return loaded;
+  }
+
+  // Time since the current fragment was loaded, for smooth scrolling
+  static uint32_t offsetMs(const Game &game, uint32_t nowMs) {
+    uint32_t fragmentStartMs = game.fragmentMs(game.nowFragment);
+    uint32_t length = game.fragmentLengthMs();
+    if (nowMs <= fragmentStartMs)
+      return 0;
+    uint32_t offset = nowMs - fragmentStartMs;
+    return offset < length ? offset : length;
+  }
+};
@@ -0,0 +1,187 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "include/vector.hpp"
+
+#include "Game.hpp"
+
+// Everything a Game changes while playing except the highway cells, which
+// are stored next to it (see SnapshotBuffer and ViewState). Trivially
+// copyable and allocation-free; the per-lane arrays are sized for the
+// largest game settings allow.
+struct SnapshotState {
+  static constexpr std::size_t MAX_LANES = 9;      // keys A..L
+  static constexpr std::size_t MAX_FRAGMENTS = 100; // settings upper bound
+
+  uint16_t lanes;
+  uint16_t fragments;
+  uint16_t highwayStart;
+  uint16_t lanePressed; // bit i: lane i pressed
+  uint32_t nowFragment;
+
+  uint32_t score, perfectCount, greatCount, goodCount, badCount, missCount,
+      combo, maxCombo, heldTime;
+
+  uint32_t holdPressedTime[MAX_LANES];
+  uint32_t holdOverflow[MAX_LANES];
+  Effect laneEffects[MAX_LANES];
+  Effect centerEffects[2];
+};
+
+static_assert(std::is_trivially_copyable_v<SnapshotState>);
+
+// Fills state and copies the highway into cells, which must hold the
+// game's lanes x fragments. Returns false if the game is larger than a
+// snapshot can hold.
+inline bool saveSnapshot(const Game &game, SnapshotState &snap,
+                         int8_t *cells) {
+  if (game.lanes > SnapshotState::MAX_LANES ||
+      game.fragments > SnapshotState::MAX_FRAGMENTS)
+    return false;
+
+  snap.lanes = static_cast<uint16_t>(game.lanes);
+  snap.fragments = static_cast<uint16_t>(game.fragments);
+  snap.highwayStart = static_cast<uint16_t>(game.highway.getStart());
+  snap.nowFragment = static_cast<uint32_t>(game.nowFragment);
+
+  snap.score = game.score;
+  snap.perfectCount = game.perfectCount;
+  snap.greatCount = game.greatCount;
+  snap.goodCount = game.goodCount;
+  snap.badCount = game.badCount;
+  snap.missCount = game.missCount;
+  snap.combo = game.combo;
+  snap.maxCombo = game.maxCombo;
+  snap.heldTime = game.heldTime;
+
+  snap.lanePressed = 0;
+  for (std::size_t lane = 0; lane < game.lanes; ++lane) {
+    if (game.lanePressed[lane])
+      snap.lanePressed |= 1u << lane;
+    snap.holdPressedTime[lane] = game.holdPressedTime[lane];
+    snap.holdOverflow[lane] = game.holdOverflow[lane];
+    snap.laneEffects[lane] = game.laneEffects[lane];
+  }
+
+  std::size_t i = 0;
+  for (const Effect &e : game.centerEffects)
+    snap.centerEffects[i++] = e;
+
+  std::memcpy(cells, game.highway.data(), game.highway.size());
+  return true;
+}
+
+// Writes a snapshot back into the game's existing buffers, no allocation.
+// The game must have the snapshot's lanes and fragments.
+inline bool restoreSnapshot(Game &game, const SnapshotState &snap,
+                            const int8_t *cells) {
+  if (game.lanes != snap.lanes || game.fragments != snap.fragments)
+    return false;
+
+  game.nowFragment = snap.nowFragment;
+
+  game.score = snap.score;
+  game.perfectCount = snap.perfectCount;
+  game.greatCount = snap.greatCount;
+  game.goodCount = snap.goodCount;
+  game.badCount = snap.badCount;
+  game.missCount = snap.missCount;
+  game.combo = snap.combo;
+  game.maxCombo = snap.maxCombo;
+  game.heldTime = snap.heldTime;
+
+  for (std::size_t lane = 0; lane < game.lanes; ++lane) {
+    game.lanePressed[lane] = (snap.lanePressed >> lane) & 1u;
+    game.holdPressedTime[lane] = snap.holdPressedTime[lane];
+    game.holdOverflow[lane] = snap.holdOverflow[lane];
+    game.laneEffects[lane] = snap.laneEffects[lane];
+  }
+
+  game.centerEffects.clear();
+  for (const Effect &e : snap.centerEffects)
+    if (e.content != 0)
+      game.centerEffects.push(e);
+
+  std::memcpy(game.highway.data(), cells, game.highway.size());
+  game.highway.setStart(snap.highwayStart);
+  return true;
+}
+
+// Checkpoints of one game (practice sections, retry, rollback on late
+// input), packed back to back in one flat buffer. Each is a SnapshotState
+// followed by exactly the game's lanes x fragments cells, 412 bytes for a
+// 4 x 40 game. Saving and restoring are memcpy; after reserve() saving
+// never allocates.
+class SnapshotBuffer {
+private:
+  mystd::vector<unsigned char> bytes;
+  std::size_t cellCount = 0; // lanes x fragments of the saved game
+  std::size_t count = 0;
+
+  unsigned char *record(std::size_t index) {
+    return bytes.data() + index * recordBytes();
+  }
+  const unsigned char *record(std::size_t index) const {
+    return bytes.data() + index * recordBytes();
+  }
+
+public:
+  std::size_t size() const noexcept { return count; }
+  bool empty() const noexcept { return count == 0; }
+  std::size_t recordBytes() const noexcept {
+    return sizeof(SnapshotState) + cellCount;
+  }
+
+  void reserve(const Game &game, std::size_t checkpoints) {
+    bytes.reserve(checkpoints *
+                  (sizeof(SnapshotState) + game.lanes * game.fragments));
+  }
+
+  // Keeps the first n checkpoints, e.g. to drop those after a rollback
+  void truncate(std::size_t n) {
+    if (n >= count)
+      return;
+    count = n;
+    bytes.resize(n * recordBytes());
+  }
+
+  void clear() { truncate(0); }
+
+  // Appends a checkpoint. Returns false if the game is larger than a
+  // snapshot can hold or not the size of the checkpoints already saved.
+  bool save(const Game &game) {
+    std::size_t cells = game.lanes * game.fragments;
+    if (count == 0)
+      cellCount = cells;
+    else if (cells != cellCount)
+      return false;
+
+    std::size_t at = bytes.size();
+    bytes.resize(at + recordBytes());
+    SnapshotState state;
+    if (!saveSnapshot(game, state,
+                      reinterpret_cast<int8_t *>(record(count) +
+                                                 sizeof(SnapshotState)))) {
+      bytes.resize(at);
+      return false;
+    }
+    std::memcpy(record(count), &state, sizeof(SnapshotState));
+    ++count;
+    return true;
+  }
+
+  bool restore(Game &game, std::size_t index) const {
+    if (index >= count)
+      return false;
+    SnapshotState state;
+    std::memcpy(&state, record(index), sizeof(SnapshotState));
+    return restoreSnapshot(
+        game, state,
+        reinterpret_cast<const int8_t *>(record(index) +
+                                         sizeof(SnapshotState)));
+  }
+};
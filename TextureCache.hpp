@@ -0,0 +1,145 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+struct TextureCacheStats {
+  uint64_t hits = 0;
+  uint64_t misses = 0;
+  uint64_t evictions = 0;
+  std::size_t entries = 0;
+  std::size_t bytes = 0;     // resident, estimated as w * h * 4
+  double creationMs = 0;     // total time spent in create callbacks
+};
+
+// Keyed SDL_Texture cache with a byte budget. When an insert would exceed the
+// budget the least recently used textures are destroyed first; the texture
+// just inserted is never evicted, so a single oversized entry still works.
+// Key is anything std::hash takes; integer ids keep lookups allocation-free.
+template <class Key> class BasicTextureCache {
+private:
+  struct Entry {
+    SDL_Texture *texture;
+    std::size_t bytes;
+    typename std::list<Key>::iterator use;
+  };
+
+  std::string name_;
+  std::size_t budget;
+  std::list<Key> lru; // front = most recently used
+  std::unordered_map<Key, Entry> entries;
+  TextureCacheStats stats_;
+
+  static std::size_t textureBytes(SDL_Texture *texture) {
+    int w = 0, h = 0;
+    SDL_QueryTexture(texture, nullptr, nullptr, &w, &h);
+    return static_cast<std::size_t>(w) * h * 4;
+  }
+
+  void evictFor(std::size_t bytes) {
+    while (!lru.empty() && stats_.bytes + bytes > budget) {
+      auto it = entries.find(lru.back());
+      stats_.bytes -= it->second.bytes;
+      SDL_DestroyTexture(it->second.texture);
+      entries.erase(it);
+      lru.pop_back();
+      ++stats_.evictions;
+    }
+  }
+
+public:
+  BasicTextureCache(std::string name, std::size_t budgetBytes)
+      : name_(std::move(name)), budget(budgetBytes) {}
+
+  BasicTextureCache(const BasicTextureCache &) = delete;
+  BasicTextureCache &operator=(const BasicTextureCache &) = delete;
+
+  ~BasicTextureCache() { clear(); }
+
+  // Cached texture or nullptr, counts as a hit or a miss
+  SDL_Texture *find(const Key &key) {
+    auto it = entries.find(key);
+    if (it == entries.end()) {
+      ++stats_.misses;
+      return nullptr;
+    }
+    ++stats_.hits;
+    lru.splice(lru.begin(), lru, it->second.use);
+    return it->second.texture;
+  }
+
+  // Takes ownership of texture, replacing any entry under the same key
+  void insert(const Key &key, SDL_Texture *texture) {
+    if (!texture)
+      return;
+    erase(key);
+    std::size_t bytes = textureBytes(texture);
+    evictFor(bytes);
+    lru.push_front(key);
+    entries.emplace(key, Entry{texture, bytes, lru.begin()});
+    stats_.bytes += bytes;
+  }
+
+  // find(), and on a miss insert create() (which may return nullptr)
+  template <class Create>
+  SDL_Texture *getOrCreate(const Key &key, Create &&create) {
+    if (SDL_Texture *texture = find(key))
+      return texture;
+    auto begin = std::chrono::steady_clock::now();
+    SDL_Texture *texture = create();
+    stats_.creationMs += std::chrono::duration<double, std::milli>(
+                             std::chrono::steady_clock::now() - begin)
+                             .count();
+    insert(key, texture);
+    return texture;
+  }
+
+  void erase(const Key &key) {
+    auto it = entries.find(key);
+    if (it == entries.end())
+      return;
+    stats_.bytes -= it->second.bytes;
+    SDL_DestroyTexture(it->second.texture);
+    lru.erase(it->second.use);
+    entries.erase(it);
+  }
+
+  void clear() {
+    for (auto &pair : entries)
+      SDL_DestroyTexture(pair.second.texture);
+    entries.clear();
+    lru.clear();
+    stats_.bytes = 0;
+  }
+
+  void setBudget(std::size_t budgetBytes) {
+    budget = budgetBytes;
+    evictFor(0);
+  }
+
+  std::size_t getBudget() const { return budget; }
+  const std::string &name() const { return name_; }
+
+  TextureCacheStats stats() const {
+    TextureCacheStats s = stats_;
+    s.entries = entries.size();
+    return s;
+  }
+
+  void dump(std::ostream &out) const {
+    TextureCacheStats s = stats();
+    out << name_ << ": entries=" << s.entries << " bytes=" << s.bytes
+        << " budget=" << budget << " hits=" << s.hits << " misses=" << s.misses
+        << " evictions=" << s.evictions << " creation_ms=" << s.creationMs
+        << '\n';
+  }
+};
+
+using TextureCache = BasicTextureCache<std::string>;
@@ -0,0 +1,174 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include "include/algorithm-sort.hpp"
+#include "include/span.hpp"
+#include "include/vector.hpp"
+
+// From startFragment on, fragments last msPerFragment each. startMs is the
+// prefix sum of every earlier section plus any stops, so a lookup needs
+// only its own section.
+struct TimingSection {
+  uint32_t startFragment;
+  double startMs;
+  double msPerFragment;
+};
+
+// Tempo change or stop, as written in the chart
+struct TimingEvent {
+  uint32_t fragment;
+  bool stop;    // false: tempo change
+  double value; // new BPM, or stop length in ms
+};
+
+// Fragment <-> game time for charts with tempo changes and stops. Both
+// directions binary-search the sections, but first try the section of the
+// previous lookup and the one after it, so the game loop, which walks
+// forward a fragment at a time, pays O(1). The remembered section makes
+// lookups unsafe to share between threads; give every thread its own copy.
+// Fragment 0 is at 0 ms; the chart's offset is not included.
+class TimingMap {
+private:
+  mystd::vector<TimingSection> sections; // sorted, never empty
+  mutable std::size_t cursor = 0;
+
+  // Last section starting at or before `fragment`
+  std::size_t sectionOf(std::size_t fragment) const {
+    std::size_t n = sections.size();
+    if (sections[cursor].startFragment <= fragment) {
+      if (cursor + 1 == n || fragment < sections[cursor + 1].startFragment)
+        return cursor;
+      if (cursor + 2 == n || fragment < sections[cursor + 2].startFragment)
+        return ++cursor;
+    }
+    std::size_t lo = 0, hi = n; // first section after `fragment` in [lo, hi]
+    while (lo < hi) {
+      std::size_t mid = (lo + hi) / 2;
+      if (sections[mid].startFragment <= fragment)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+    return cursor = lo - 1;
+  }
+
+  // Last section starting at or before `ms`, or the first one
+  std::size_t sectionAt(double ms) const {
+    std::size_t n = sections.size();
+    if (sections[cursor].startMs <= ms) {
+      if (cursor + 1 == n || ms < sections[cursor + 1].startMs)
+        return cursor;
+      if (cursor + 2 == n || ms < sections[cursor + 2].startMs)
+        return ++cursor;
+    }
+    std::size_t lo = 0, hi = n;
+    while (lo < hi) {
+      std::size_t mid = (lo + hi) / 2;
+      if (sections[mid].startMs <= ms)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+    return cursor = lo > 0 ? lo - 1 : 0;
+  }
+
+public:
+  TimingMap() : TimingMap(100.0) {}
+
+  // Constant tempo
+  explicit TimingMap(double msPerFragment) {
+    sections.push_back({0, 0.0, msPerFragment});
+  }
+
+  // Sections as stored by CompiledChart; must start at fragment 0
+  explicit TimingMap(mystd::span<const TimingSection> stored) {
+    if (stored.empty() || stored[0].startFragment != 0)
+      sections.push_back({0, 0.0, 100.0});
+    for (const TimingSection &s : stored)
+      sections.push_back(s);
+  }
+
+  // Starting tempo plus the chart's tempo changes and stops, in any order.
+  // Events at the same fragment apply in the order given.
+  static TimingMap build(double bpm, int fragmentsPerBeat,
+                         mystd::vector<TimingEvent> events) {
+    auto msPerFragmentOf = [fragmentsPerBeat](double tempo) {
+      return 60000.0 / tempo / fragmentsPerBeat;
+    };
+    // Stable for equal fragments: sort by (fragment, original index)
+    mystd::vector<std::pair<TimingEvent, std::size_t>> ordered;
+    for (std::size_t i = 0; i < events.size(); ++i)
+      ordered.push_back({events[i], i});
+    mystd::sort(ordered.begin(), ordered.end(),
+                [](const auto &a, const auto &b) {
+                  return a.first.fragment != b.first.fragment
+                             ? a.first.fragment < b.first.fragment
+                             : a.second < b.second;
+                });
+
+    TimingMap map(msPerFragmentOf(bpm));
+    for (const auto &[e, index] : ordered) {
+      if (e.value <= 0)
+        continue;
+      TimingSection &last = map.sections.back();
+      if (e.fragment > last.startFragment)
+        map.sections.push_back({e.fragment, map.timeOf(e.fragment),
+                                last.msPerFragment});
+      if (e.stop)
+        map.sections.back().startMs += e.value;
+      else
+        map.sections.back().msPerFragment = msPerFragmentOf(e.value);
+    }
+    map.cursor = 0;
+    return map;
+  }
+
+  mystd::span<const TimingSection> getSections() const { return sections; }
+
+  // Exact start of `fragment` in ms
+  double timeOf(std::size_t fragment) const {
+    const TimingSection &s = sections[sectionOf(fragment)];
+    return s.startMs + (fragment - s.startFragment) * s.msPerFragment;
+  }
+
+  // Start of `fragment` on the game's millisecond clock
+  uint32_t fragmentMs(std::size_t fragment) const {
+    return static_cast<uint32_t>(timeOf(fragment));
+  }
+
+  // Length of `fragment` in whole ms, at least 1
+  uint32_t fragmentLengthMs(std::size_t fragment) const {
+    uint32_t length = fragmentMs(fragment + 1) - fragmentMs(fragment);
+    return length > 0 ? length : 1;
+  }
+
+  double msPerFragmentAt(std::size_t fragment) const {
+    return sections[sectionOf(fragment)].msPerFragment;
+  }
+
+  // Fractional fragment position at `ms`. During a stop it waits at the
+  // fragment the stop precedes.
+  double fragmentAt(double ms) const {
+    std::size_t i = sectionAt(ms);
+    const TimingSection &s = sections[i];
+    if (ms <= s.startMs)
+      return s.startFragment;
+    double fragment = s.startFragment + (ms - s.startMs) / s.msPerFragment;
+    if (i + 1 < sections.size() && fragment > sections[i + 1].startFragment)
+      fragment = sections[i + 1].startFragment;
+    return fragment;
+  }
+
+  // Whole-ms fragment length if the tempo never changes, otherwise 0.
+  // InputLog stores it, with 0 meaning "take the timing from the chart".
+  uint32_t uniformMs() const {
+    if (sections.size() != 1 || sections[0].startMs != 0)
+      return 0;
+    double ms = sections[0].msPerFragment;
+    return ms == std::floor(ms) ? static_cast<uint32_t>(ms) : 0;
+  }
+};
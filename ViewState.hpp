@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "include/array.hpp"
+
+#include "Game.hpp"
+#include "Snapshot.hpp"
+
+// Everything Renderer draws, published by the simulation once per tick.
+// A flat snapshot, so the renderer never touches the live Game. Unlike a
+// SnapshotBuffer checkpoint the cells are sized for the largest game, so a
+// view is one fixed-size value the triple buffer can hold.
+struct ViewState : SnapshotState {
+  int8_t cells[MAX_LANES * MAX_FRAGMENTS]; // highway, physical row order
+  uint32_t fragmentStartMs; // when the current fragment was loaded
+  uint32_t msPerFragment;   // length of the current fragment
+  uint32_t nowMs;           // game time it was published at
+  float simulateMs; // cost of the tick that produced it
+
+  // Fragment 0 is the top of the screen, like Highway::row
+  const int8_t *row(std::size_t fragment) const noexcept {
+    std::size_t r = highwayStart + fragment;
+    if (r >= fragments)
+      r -= fragments;
+    return cells + r * lanes;
+  }
+
+  bool pressed(std::size_t lane) const noexcept {
+    return (lanePressed >> lane) & 1u;
+  }
+
+  // Time since the current fragment was loaded, for smooth scrolling
+  uint32_t offsetMs(uint32_t renderMs) const noexcept {
+    if (renderMs <= fragmentStartMs)
+      return 0;
+    uint32_t offset = renderMs - fragmentStartMs;
+    return offset < msPerFragment ? offset : msPerFragment;
+  }
+};
+
+inline bool saveView(const Game &game, uint32_t nowMs, ViewState &view) {
+  if (!saveSnapshot(game, view, view.cells))
+    return false;
+  view.fragmentStartMs = game.fragmentMs(game.nowFragment);
+  view.msPerFragment = game.fragmentLengthMs();
+  view.nowMs = nowMs;
+  view.simulateMs = 0;
+  return true;
+}
+
+// Single producer, single consumer, never blocks either side. The writer
+// fills back() and publish()es it; the reader calls update() and then reads
+// front(), which stays untouched until its next update(). The third slot
+// holds the latest published value in between, so the writer can always
+// start a new one and the reader only ever sees complete values.
+template <class T> class TripleBuffer {
+private:
+  static constexpr uint8_t DIRTY = 4; // middle slot holds an unread value
+
+  mystd::array<T, 3> slots{};
+  alignas(64) std::atomic<uint8_t> middle{1};
+  alignas(64) uint8_t backIndex = 0;  // writer only
+  alignas(64) uint8_t frontIndex = 2; // reader only
+
+public:
+  T &back() noexcept { return slots[backIndex]; }
+
+  void publish() noexcept {
+    uint8_t prev =
+        middle.exchange(backIndex | DIRTY, std::memory_order_acq_rel);
+    backIndex = prev & ~DIRTY;
+  }
+
+  // Returns true if a newer value was taken
+  bool update() noexcept {
+    if (!(middle.load(std::memory_order_relaxed) & DIRTY))
+      return false;
+    uint8_t prev = middle.exchange(frontIndex, std::memory_order_acq_rel);
+    frontIndex = prev & ~DIRTY;
+    return true;
+  }
+
+  const T &front() const noexcept { return slots[frontIndex]; }
+};
+
+using ViewBuffer = TripleBuffer<ViewState>;
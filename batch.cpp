@@ -0,0 +1,190 @@
+#if __cplusplus < 202002L
+#error "Require C++20 or later"
+#endif
+
+// Chart rating: plays every chart with every bot policy on all cores and
+// writes score distributions, no SDL required:
+//   g++ batch.cpp -o batch -I. -std=c++20 -O2 -pthread
+//   ./batch [-runs N] [-threads T] [-lanes L] [-fragments F] [-out file.csv]
+//           <chart>...
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "include/vector.hpp"
+
+#include "Bots.hpp"
+#include "ChartParser.hpp"
+#include "Game.hpp"
+#include "KeyNoteData.hpp"
+#include "Replay.hpp"
+#include "TimingMap.hpp"
+
+struct Chart {
+  std::string path;
+  mystd::vector<KeyNoteData> notes; // shared read-only by every worker
+  TimingMap timing; // copied into every worker's Game
+};
+
+struct RunResult {
+  uint32_t score;
+  uint32_t perfectCount;
+  uint32_t missCount;
+  uint32_t maxCombo;
+};
+
+int main(int argc, char *argv[]) {
+  std::size_t runs = 100;
+  std::size_t threads = std::thread::hardware_concurrency();
+  std::size_t lanes = 4;
+  std::size_t fragments = 10;
+  std::string outPath = "batch_results.csv";
+  std::vector<std::string> chartPaths;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "-runs" && i + 1 < argc)
+      runs = std::strtoul(argv[++i], nullptr, 10);
+    else if (arg == "-threads" && i + 1 < argc)
+      threads = std::strtoul(argv[++i], nullptr, 10);
+    else if (arg == "-lanes" && i + 1 < argc)
+      lanes = std::strtoul(argv[++i], nullptr, 10);
+    else if (arg == "-fragments" && i + 1 < argc)
+      fragments = std::strtoul(argv[++i], nullptr, 10);
+    else if (arg == "-out" && i + 1 < argc)
+      outPath = argv[++i];
+    else
+      chartPaths.push_back(arg);
+  }
+  if (chartPaths.empty()) {
+    std::cerr << "Usage: " << argv[0]
+              << " [-runs N] [-threads T] [-lanes L] [-fragments F]"
+                 " [-out file.csv] <chart>..."
+              << std::endl;
+    return 1;
+  }
+  if (threads == 0)
+    threads = 1;
+  if (runs == 0)
+    runs = 1;
+
+  // Charts are parsed once up front and never written again
+  std::vector<std::unique_ptr<Chart>> charts;
+  for (const std::string &path : chartPaths) {
+    auto chart = std::make_unique<Chart>();
+    chart->path = path;
+    ChartParser parser(chart->notes);
+    if (!parser.load(path))
+      continue;
+    chart->timing = parser.getTimingMap();
+    charts.push_back(std::move(chart));
+  }
+
+  const std::vector<Bot> bots = {
+      perfectBot(),
+      humanBot(15.0, 0.01),
+      humanBot(30.0, 0.03),
+      humanBot(60.0, 0.08),
+      laneBiasedBot(20.0, 0.02, 2.0),
+  };
+
+  // One job per (chart, bot, run); workers pull job indices from a counter
+  // and write only their own result slots
+  std::size_t perChart = bots.size() * runs;
+  std::size_t jobCount = charts.size() * perChart;
+  std::vector<RunResult> results(jobCount);
+  std::atomic<std::size_t> nextJob{0};
+
+  auto worker = [&](std::size_t id) {
+    InputLog log;
+    std::unique_ptr<Game> game;
+    const Chart *current = nullptr;
+
+    for (std::size_t job = nextJob.fetch_add(1, std::memory_order_relaxed);
+         job < jobCount;
+         job = nextJob.fetch_add(1, std::memory_order_relaxed)) {
+      const Chart &chart = *charts[job / perChart];
+      const Bot &bot = bots[job % perChart / runs];
+
+      if (current != &chart) {
+        game = std::make_unique<Game>(lanes, fragments, chart.timing,
+                                      chart.notes);
+        current = &chart;
+      } else {
+        game->restart();
+      }
+
+      std::mt19937 rng(static_cast<uint32_t>(job * 2654435761u + id));
+      bot.play(*game, rng, log);
+      simulate(*game, log, chartLength(*game));
+
+      results[job] = {game->score, game->perfectCount, game->missCount,
+                      game->maxCombo};
+    }
+  };
+
+  auto begin = std::chrono::steady_clock::now();
+  std::vector<std::thread> pool;
+  for (std::size_t i = 0; i < threads; ++i)
+    pool.emplace_back(worker, i);
+  for (std::thread &t : pool)
+    t.join();
+  auto end = std::chrono::steady_clock::now();
+  double wallMs =
+      std::chrono::duration<double, std::milli>(end - begin).count();
+
+  std::ofstream out(outPath);
+  if (!out.is_open()) {
+    std::cerr << "[ERROR] Cannot write results: " << outPath << std::endl;
+    return 1;
+  }
+  out << "chart,bot,runs,mean,stddev,min,p10,p50,p90,max,mean_perfect,"
+         "mean_miss,mean_max_combo\n";
+
+  std::vector<uint32_t> scores(runs);
+  for (std::size_t c = 0; c < charts.size(); ++c) {
+    for (std::size_t b = 0; b < bots.size(); ++b) {
+      const RunResult *r = &results[c * perChart + b * runs];
+
+      double sum = 0, sumSq = 0, perfect = 0, miss = 0, combo = 0;
+      for (std::size_t i = 0; i < runs; ++i) {
+        scores[i] = r[i].score;
+        sum += r[i].score;
+        sumSq += double(r[i].score) * r[i].score;
+        perfect += r[i].perfectCount;
+        miss += r[i].missCount;
+        combo += r[i].maxCombo;
+      }
+      std::sort(scores.begin(), scores.end());
+      double mean = sum / runs;
+      double stddev = std::sqrt(std::max(0.0, sumSq / runs - mean * mean));
+      auto pct = [&](double p) { return scores[(std::size_t)(p * (runs - 1))]; };
+
+      out << charts[c]->path << ',' << bots[b].name << ',' << runs << ','
+          << mean << ',' << stddev << ',' << scores.front() << ',' << pct(0.1)
+          << ',' << pct(0.5) << ',' << pct(0.9) << ',' << scores.back() << ','
+          << perfect / runs << ',' << miss / runs << ',' << combo / runs
+          << '\n';
+    }
+  }
+
+  std::cout << "[OK] " << jobCount << " games on " << threads
+            << " threads in " << wallMs << " ms ("
+            << (wallMs > 0 ? jobCount * 1000.0 / wallMs : 0) << " games/s)"
+            << std::endl;
+  std::cout << "[OK] Results written to " << outPath << std::endl;
+  return 0;
+}
@@ -0,0 +1,207 @@
+#pragma once // algorithm-sort.hpp
+
+#include <concepts>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <utility>
+
+namespace mystd {
+
+namespace sort_detail {
+
+constexpr std::ptrdiff_t INSERTION_CUTOFF = 16;
+
+template <class It, class Comp>
+constexpr void siftDown(It first, std::ptrdiff_t size, std::ptrdiff_t root,
+                        Comp &comp) {
+  auto value = std::move(*(first + root));
+  while (true) {
+    std::ptrdiff_t child = 2 * root + 1;
+    if (child >= size)
+      break;
+    if (child + 1 < size && comp(*(first + child), *(first + child + 1)))
+      ++child;
+    if (!comp(value, *(first + child)))
+      break;
+    *(first + root) = std::move(*(first + child));
+    root = child;
+  }
+  *(first + root) = std::move(value);
+}
+
+template <class It, class Comp>
+constexpr void heapSort(It first, It last, Comp &comp) {
+  std::ptrdiff_t size = last - first;
+  for (std::ptrdiff_t i = size / 2; i-- > 0;)
+    siftDown(first, size, i, comp);
+  while (size > 1) {
+    --size;
+    std::iter_swap(first, first + size);
+    siftDown(first, size, 0, comp);
+  }
+}
+
+template <class It, class Comp>
+constexpr void insertionSort(It first, It last, Comp &comp) {
+  if (first == last)
+    return;
+  for (It i = first + 1; i < last; ++i) {
+    auto value = std::move(*i);
+    It j = i;
+    for (; j > first && comp(value, *(j - 1)); --j)
+      *j = std::move(*(j - 1));
+    *j = std::move(value);
+  }
+}
+
+// No bounds check: something not greater than *last must sit before it
+template <class It, class Comp>
+constexpr void unguardedInsert(It last, Comp &comp) {
+  auto value = std::move(*last);
+  It prev = last - 1;
+  while (comp(value, *prev)) {
+    *last = std::move(*prev);
+    last = prev--;
+  }
+  *last = std::move(value);
+}
+
+template <class It, class Comp>
+constexpr void moveMedianToFirst(It result, It a, It b, It c, Comp &comp) {
+  if (comp(*a, *b)) {
+    if (comp(*b, *c))
+      std::iter_swap(result, b);
+    else if (comp(*a, *c))
+      std::iter_swap(result, c);
+    else
+      std::iter_swap(result, a);
+  } else if (comp(*a, *c)) {
+    std::iter_swap(result, a);
+  } else if (comp(*b, *c)) {
+    std::iter_swap(result, c);
+  } else {
+    std::iter_swap(result, b);
+  }
+}
+
+// Hoare partition around *pivot, which lies outside [first, last). Stops on
+// equal elements, so runs of equal keys still split evenly.
+template <class It, class Comp>
+constexpr It unguardedPartition(It first, It last, It pivot, Comp &comp) {
+  while (true) {
+    while (comp(*first, *pivot))
+      ++first;
+    --last;
+    while (comp(*pivot, *last))
+      --last;
+    if (!(first < last))
+      return first;
+    std::iter_swap(first, last);
+    ++first;
+  }
+}
+
+template <class It, class Comp>
+constexpr bool sortedRun(It first, It last, Comp &comp) {
+  for (It i = first + 1; i < last; ++i)
+    if (comp(*i, *(i - 1)))
+      return false;
+  return true;
+}
+
+// Quicksort down to INSERTION_CUTOFF-sized ranges, left for one final
+// insertion sort; heapsort once depthLimit runs out
+template <class It, class Comp>
+constexpr void introsortLoop(It first, It last, int depthLimit, Comp &comp) {
+  while (last - first > INSERTION_CUTOFF) {
+    if (depthLimit-- == 0) {
+      heapSort(first, last, comp);
+      return;
+    }
+    std::ptrdiff_t size = last - first;
+    It mid = first + size / 2;
+    if (size > 128) { // ninther
+      std::ptrdiff_t step = size / 8;
+      moveMedianToFirst(first + 1, first + 1, first + 1 + step,
+                        first + 1 + 2 * step, comp);
+      moveMedianToFirst(mid, mid - step, mid, mid + step, comp);
+      moveMedianToFirst(last - 1, last - 1 - 2 * step, last - 1 - step,
+                        last - 1, comp);
+      moveMedianToFirst(first, first + 1, mid, last - 1, comp);
+    } else {
+      moveMedianToFirst(first, first + 1, mid, last - 1, comp);
+    }
+    It cut = unguardedPartition(first + 1, last, first, comp);
+
+    // Recurse into the smaller side so the stack stays O(log n)
+    if (cut - first < last - cut) {
+      introsortLoop(first, cut, depthLimit, comp);
+      first = cut;
+    } else {
+      introsortLoop(cut, last, depthLimit, comp);
+      last = cut;
+    }
+  }
+}
+
+} // namespace sort_detail
+
+// Introsort: median-of-three (ninther above 128 elements) quicksort,
+// heapsort past 2 log2(n) levels, insertion sort below 16 elements.
+// Already sorted and strictly descending input take one linear pass.
+// O(n log n) worst case, not stable.
+template <std::random_access_iterator It, class Comp>
+  requires std::sortable<It, Comp>
+constexpr void sort(It first, It last, Comp comp) {
+  std::ptrdiff_t size = last - first;
+  if (size < 2)
+    return;
+
+  It i = first + 1;
+  while (i < last && !comp(*i, *(i - 1)))
+    ++i;
+  if (i == last)
+    return;
+  if (i == first + 1) {
+    while (i < last && comp(*i, *(i - 1)))
+      ++i;
+    if (i == last) {
+      for (It a = first, b = last - 1; a < b; ++a, --b)
+        std::iter_swap(a, b);
+      return;
+    }
+  }
+
+  int depthLimit = 0;
+  for (std::ptrdiff_t n = size; n > 1; n >>= 1)
+    depthLimit += 2;
+  sort_detail::introsortLoop(first, last, depthLimit, comp);
+
+  if (size > sort_detail::INSERTION_CUTOFF) {
+    It cutoff = first + sort_detail::INSERTION_CUTOFF;
+    sort_detail::insertionSort(first, cutoff, comp);
+    for (It j = cutoff; j < last; ++j)
+      sort_detail::unguardedInsert(j, comp);
+  } else {
+    sort_detail::insertionSort(first, last, comp);
+  }
+}
+
+template <std::random_access_iterator It>
+  requires std::sortable<It>
+constexpr void sort(It first, It last) {
+  mystd::sort(first, last, std::less<>{});
+}
+
+template <std::random_access_iterator It, class Comp>
+constexpr bool is_sorted(It first, It last, Comp comp) {
+  return last - first < 2 || sort_detail::sortedRun(first, last, comp);
+}
+
+template <std::random_access_iterator It>
+constexpr bool is_sorted(It first, It last) {
+  return mystd::is_sorted(first, last, std::less<>{});
+}
+
+} // namespace mystd
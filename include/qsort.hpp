@@ -1,39 +1,21 @@
 #pragma once
 
-#include <algorithm>
 #include <concepts>
 #include <iterator>
 
-#include "swap.hpp"
+#include "algorithm-sort.hpp"
 
+// Kept for older callers; forwards to the introsort in algorithm-sort.hpp.
+// The former Lomuto quicksort pivoted on the last element and went
+// quadratic on sorted input.
 template<std::random_access_iterator RandomIt>
 requires std::sortable<RandomIt>
 constexpr void qsort(RandomIt first, RandomIt last) {
-    if (first >= last || std::distance(first, last) <= 1) return;
-    RandomIt i = first;
-    for (RandomIt j=first; j<last-1; j++) {
-        if (*j < *(last - 1)) {
-          mystd::swap(*i, *j);
-          ++i;
-        }
-    }
-    mystd::swap(*i, *(last - 1));
-    qsort(first, i);
-    qsort(i+1, last);
+    mystd::sort(first, last);
 }
 
 template<std::random_access_iterator RandomIt, class Compare>
 requires std::sortable<RandomIt, Compare>
 constexpr void qsort(RandomIt first, RandomIt last, Compare comp) {
-    if (first >= last || std::distance(first, last) <= 1) return;
-    RandomIt i = first;
-    for (RandomIt j=first; j<last-1; j++) {
-        if (comp(*j, *(last - 1))) {
-          mystd::swap(*i, *j);
-          ++i;
-        }
-    }
-    mystd::swap(*i, *(last - 1));
-    qsort(first, i, comp);
-    qsort(i+1, last, comp);
+    mystd::sort(first, last, comp);
 }
@@ -0,0 +1,92 @@
+#pragma once // span.hpp
+
+#include <cstddef>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+
+#include "range-access.hpp"
+
+namespace mystd {
+
+// Dynamic extent only: a pointer and a size into storage owned elsewhere
+template <class T> class span {
+public:
+  using element_type = T;
+  using value_type = std::remove_cv_t<T>;
+  using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+  using pointer = T *;
+  using const_pointer = const T *;
+  using reference = T &;
+  using const_reference = const T &;
+  using iterator = T *;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+
+private:
+  T *ptr = nullptr;
+  std::size_t count = 0;
+
+public:
+  constexpr span() noexcept = default;
+  constexpr span(T *first, std::size_t n) noexcept : ptr(first), count(n) {}
+  constexpr span(T *first, T *last) noexcept
+      : ptr(first), count(static_cast<std::size_t>(last - first)) {}
+
+  template <std::size_t N>
+  constexpr span(std::type_identity_t<T> (&array)[N]) noexcept
+      : ptr(array), count(N) {}
+
+  // Any contiguous container with data() and size(), e.g. mystd::vector
+  template <class C>
+    requires(!std::is_same_v<std::remove_cvref_t<C>, span> &&
+             std::is_convertible_v<decltype(std::declval<C &>().data()), T *>)
+  constexpr span(C &c) noexcept(noexcept(c.data()) && noexcept(c.size()))
+      : ptr(c.data()), count(c.size()) {}
+
+  template <class U>
+    requires(std::is_convertible_v<U (*)[], T (*)[]>)
+  constexpr span(const span<U> &other) noexcept
+      : ptr(other.data()), count(other.size()) {}
+
+  constexpr iterator begin() const noexcept { return ptr; }
+  constexpr iterator end() const noexcept { return ptr + count; }
+  constexpr reverse_iterator rbegin() const noexcept {
+    return reverse_iterator(end());
+  }
+  constexpr reverse_iterator rend() const noexcept {
+    return reverse_iterator(begin());
+  }
+
+  constexpr reference front() const { return ptr[0]; }
+  constexpr reference back() const { return ptr[count - 1]; }
+  constexpr reference operator[](std::size_t index) const {
+    return ptr[index];
+  }
+  constexpr reference at(std::size_t index) const {
+    if (index >= count)
+      throw std::out_of_range("mystd::span::at");
+    return ptr[index];
+  }
+  constexpr pointer data() const noexcept { return ptr; }
+
+  constexpr std::size_t size() const noexcept { return count; }
+  constexpr std::size_t size_bytes() const noexcept {
+    return count * sizeof(T);
+  }
+  [[nodiscard]] constexpr bool empty() const noexcept { return count == 0; }
+
+  constexpr span first(std::size_t n) const { return {ptr, n}; }
+  constexpr span last(std::size_t n) const { return {ptr + count - n, n}; }
+  constexpr span subspan(std::size_t offset) const {
+    return {ptr + offset, count - offset};
+  }
+  constexpr span subspan(std::size_t offset, std::size_t n) const {
+    return {ptr + offset, n};
+  }
+};
+
+template <class C>
+span(C &) -> span<std::remove_pointer_t<decltype(std::declval<C &>().data())>>;
+
+} // namespace mystd
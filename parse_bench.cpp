@@ -0,0 +1,131 @@
+#if __cplusplus < 202002L
+#error "Require C++20 or later"
+#endif
+
+// Chart parser throughput: parses a synthetic marathon chart (or the given
+// chart files) from memory several times and reports MB/s, no SDL required:
+//   g++ parse_bench.cpp -o parse_bench -I. -std=c++20 -O2
+//   ./parse_bench [-mb N] [-runs N] [chart]...
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "include/vector.hpp"
+
+#include "ChartParser.hpp"
+#include "KeyNoteData.hpp"
+
+// Every kind of line the format has: density changes, taps, chords, holds,
+// empty cells, comments and mouse objects, until `bytes` is reached
+std::string marathonChart(std::size_t bytes) {
+  std::mt19937 rng(1);
+  std::string text = "&bpm=180\n&offset=0\n&fragments=4\n"
+                     "&music=./music/marathon.mp3\n\n&keynotes=\n";
+  text.reserve(bytes + 4096);
+  const int densities[] = {4, 8, 16};
+
+  std::size_t keyBytes = bytes * 3 / 4;
+  for (std::size_t bar = 0; text.size() < keyBytes; ++bar) {
+    if (bar % 16 == 0) {
+      text += "# section " + std::to_string(bar / 16) + "\n{" +
+              std::to_string(densities[rng() % 3]) + "}\n";
+    }
+    for (int cell = 0; cell < 4; ++cell) {
+      switch (rng() % 6) {
+      case 0:
+        break;
+      case 1:
+        text += std::to_string(rng() % 4 + 1) + "/" +
+                std::to_string(rng() % 4 + 1);
+        break;
+      case 2:
+        text += std::to_string(rng() % 4 + 1) + "h[" +
+                std::to_string(rng() % 4 + 1) + "]";
+        break;
+      default:
+        text += std::to_string(rng() % 4 + 1);
+      }
+      text += ',';
+    }
+    text += '\n';
+  }
+
+  text += "\n&mousenotes=\n{4}\n";
+  while (text.size() < bytes) {
+    for (int cell = 0; cell < 4; ++cell) {
+      if (rng() % 2)
+        text += (rng() % 2 ? 'G' : 'R') + std::to_string(rng() % 4 + 1);
+      text += ',';
+    }
+    text += '\n';
+  }
+  return text;
+}
+
+void bench(const std::string &name, const std::string &text,
+           std::size_t runs) {
+  mystd::vector<KeyNoteData> notes;
+  ChartParser parser(notes);
+  parser.parse(text); // warm-up, and sizes the note vectors
+
+  std::vector<double> seconds;
+  for (std::size_t i = 0; i < runs; ++i) {
+    auto begin = std::chrono::steady_clock::now();
+    parser.parse(text);
+    auto end = std::chrono::steady_clock::now();
+    seconds.push_back(std::chrono::duration<double>(end - begin).count());
+  }
+  std::sort(seconds.begin(), seconds.end());
+  double median = seconds[seconds.size() / 2];
+  double mb = text.size() / 1e6;
+  std::size_t count = notes.size() + parser.getMouseNotes().size();
+
+  std::cout << name << ',' << text.size() << ',' << count << ','
+            << median * 1000 << ',' << mb / median << ','
+            << count / median / 1e6 << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+  std::size_t megabytes = 16;
+  std::size_t runs = 10;
+  std::vector<std::string> charts;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "-mb" && i + 1 < argc)
+      megabytes = std::strtoul(argv[++i], nullptr, 10);
+    else if (arg == "-runs" && i + 1 < argc)
+      runs = std::strtoul(argv[++i], nullptr, 10);
+    else if (!arg.empty() && arg[0] == '-') {
+      std::cerr << "Usage: " << argv[0] << " [-mb N] [-runs N] [chart]..."
+                << std::endl;
+      return 1;
+    } else
+      charts.push_back(arg);
+  }
+  if (runs == 0)
+    runs = 1;
+
+  std::cout << "chart,bytes,notes,median_ms,mb_per_s,million_notes_per_s\n";
+  if (charts.empty())
+    bench("synthetic", marathonChart(megabytes << 20), runs);
+  for (const std::string &path : charts) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+      std::cerr << "[ERROR] Cannot open chart: " << path << std::endl;
+      return 1;
+    }
+    std::string text((std::istreambuf_iterator<char>(file)),
+                     std::istreambuf_iterator<char>());
+    bench(path, text, runs);
+  }
+  return 0;
+}
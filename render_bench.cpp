@@ -0,0 +1,189 @@
+#if __cplusplus < 202002L
+#error "Require C++20 or later"
+#endif
+
+// Offscreen renderer benchmark: draws a scripted game with Renderer into a
+// software renderer on a memory surface, no window or display needed:
+//   g++ render_bench.cpp -o render_bench -I. -std=c++20 -O2
+//       -lSDL2 -lSDL2_image -lSDL2_ttf
+//   ./render_bench [-frames N] [-out file.csv]
+// Prints one CSV row per lanes x fragments x window size.
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_image.h>
+#include <SDL2/SDL_ttf.h>
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "include/vector.hpp"
+
+#include "Bots.hpp"
+#include "Game.hpp"
+#include "KeyNoteData.hpp"
+#include "Renderer.hpp"
+#include "Replay.hpp"
+#include "Scheduler.hpp"
+#include "ViewState.hpp"
+
+constexpr uint32_t MS_PER_FRAGMENT = 100;
+constexpr double FRAME_MS = 1000.0 / 60.0;
+
+// Taps walking across the lanes with a hold every few fragments, dense
+// enough to keep every lane busy
+mystd::vector<KeyNoteData> scriptedChart(std::size_t lanes,
+                                         std::size_t length) {
+  mystd::vector<KeyNoteData> notes;
+  for (std::size_t f = 0; f < length; ++f) {
+    notes.push_back({f, f * 7 % lanes, -1});
+    if (f % 8 == 0)
+      notes.push_back({f, (f * 7 + 3) % lanes, 4});
+  }
+  return notes;
+}
+
+struct BenchResult {
+  double p50, p95, p99, max;
+  double meanDrawCalls;
+  double meanTextureCreations;
+  uint32_t maxTextureCreations;
+};
+
+BenchResult runBench(std::size_t lanes, std::size_t fragments, int w, int h,
+                     std::size_t frames, TTF_Font *large, TTF_Font *medium,
+                     TTF_Font *small) {
+  SDL_Surface *surface =
+      SDL_CreateRGBSurfaceWithFormat(0, w, h, 32, SDL_PIXELFORMAT_RGBA32);
+  SDL_Renderer *rnd = SDL_CreateSoftwareRenderer(surface);
+  if (!rnd) {
+    std::cerr << "[ERROR] Software renderer: " << SDL_GetError() << std::endl;
+    std::exit(1);
+  }
+
+  std::size_t length = frames * FRAME_MS / MS_PER_FRAGMENT + 1;
+  mystd::vector<KeyNoteData> notes = scriptedChart(lanes, length);
+  Game game(lanes, fragments, MS_PER_FRAGMENT, notes);
+
+  InputLog log;
+  std::mt19937 rng(1);
+  humanBot(30.0, 0.05).play(game, rng, log);
+  InputLogCursor inputs(log);
+
+  FragmentScheduler scheduler;
+  ViewState view;
+  std::vector<double> frameMs;
+  frameMs.reserve(frames);
+  uint64_t drawCalls = 0, textureCreations = 0;
+  uint32_t maxTextureCreations = 0;
+
+  {
+    Renderer renderer(lanes, fragments, w, h, rnd, large, medium, small);
+    for (std::size_t i = 0; i < frames; ++i) {
+      uint32_t nowMs = static_cast<uint32_t>(i * FRAME_MS);
+      scheduler.advance(game, nowMs, inputs);
+      saveView(game, nowMs, view);
+
+      auto begin = std::chrono::steady_clock::now();
+      renderer.render(rnd, view, nowMs);
+      SDL_RenderPresent(rnd);
+      auto end = std::chrono::steady_clock::now();
+
+      frameMs.push_back(
+          std::chrono::duration<double, std::milli>(end - begin).count());
+      drawCalls += renderer.stats.drawCalls;
+      textureCreations += renderer.stats.textureCreations;
+      maxTextureCreations =
+          std::max(maxTextureCreations, renderer.stats.textureCreations);
+    }
+  }
+
+  SDL_DestroyRenderer(rnd);
+  SDL_FreeSurface(surface);
+
+  std::sort(frameMs.begin(), frameMs.end());
+  auto pct = [&](double p) {
+    return frameMs[static_cast<std::size_t>(p * (frameMs.size() - 1))];
+  };
+  return {pct(0.50),
+          pct(0.95),
+          pct(0.99),
+          frameMs.back(),
+          double(drawCalls) / frames,
+          double(textureCreations) / frames,
+          maxTextureCreations};
+}
+
+int main(int argc, char *argv[]) {
+  std::size_t frames = 600;
+  std::string outPath;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "-frames" && i + 1 < argc)
+      frames = std::strtoul(argv[++i], nullptr, 10);
+    else if (arg == "-out" && i + 1 < argc)
+      outPath = argv[++i];
+    else {
+      std::cerr << "Usage: " << argv[0] << " [-frames N] [-out file.csv]"
+                << std::endl;
+      return 1;
+    }
+  }
+  if (frames == 0)
+    frames = 1;
+
+  if (SDL_Init(0) < 0 || TTF_Init() < 0 ||
+      !(IMG_Init(IMG_INIT_PNG) & IMG_INIT_PNG)) {
+    std::cerr << "[ERROR] SDL init: " << SDL_GetError() << std::endl;
+    return 1;
+  }
+  TTF_Font *large = TTF_OpenFont("XITS-Regular.otf", 72);
+  TTF_Font *medium = TTF_OpenFont("XITS-Regular.otf", 40);
+  TTF_Font *small = TTF_OpenFont("XITS-Regular.otf", 28);
+  if (!large || !medium || !small) {
+    std::cerr << "[ERROR] Font: " << TTF_GetError() << std::endl;
+    return 1;
+  }
+
+  const std::size_t laneCounts[] = {4, 6, 9};
+  const std::size_t fragmentCounts[] = {10, 30, 100};
+  const int sizes[][2] = {{800, 600}, {1920, 1080}};
+
+  std::ofstream file;
+  if (!outPath.empty()) {
+    file.open(outPath);
+    if (!file.is_open()) {
+      std::cerr << "[ERROR] Cannot write results: " << outPath << std::endl;
+      return 1;
+    }
+  }
+  std::ostream &out = outPath.empty() ? std::cout : file;
+
+  out << "lanes,fragments,width,height,frames,p50_ms,p95_ms,p99_ms,max_ms,"
+         "draw_calls,texture_creations,max_texture_creations\n";
+  for (std::size_t lanes : laneCounts)
+    for (std::size_t fragments : fragmentCounts)
+      for (const int *size : sizes) {
+        BenchResult r = runBench(lanes, fragments, size[0], size[1], frames,
+                                 large, medium, small);
+        out << lanes << ',' << fragments << ',' << size[0] << ',' << size[1]
+            << ',' << frames << ',' << r.p50 << ',' << r.p95 << ',' << r.p99
+            << ',' << r.max << ',' << r.meanDrawCalls << ','
+            << r.meanTextureCreations << ',' << r.maxTextureCreations
+            << std::endl;
+      }
+
+  TTF_CloseFont(large);
+  TTF_CloseFont(medium);
+  TTF_CloseFont(small);
+  TTF_Quit();
+  IMG_Quit();
+  SDL_Quit();
+  return 0;
+}
@@ -0,0 +1,84 @@
+#if __cplusplus < 202002L
+#error "Require C++20 or later"
+#endif
+
+// Headless replay / score verification, no SDL required:
+//   g++ replay.cpp -o replay -I. -std=c++20 -O2
+//   ./replay <chart> <input log> [repeat]
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <string>
+
+#include "include/vector.hpp"
+
+#include "ChartParser.hpp"
+#include "Game.hpp"
+#include "KeyNoteData.hpp"
+#include "Replay.hpp"
+#include "TimingMap.hpp"
+
+int main(int argc, char *argv[]) {
+  if (argc < 3) {
+    std::cerr << "Usage: " << argv[0] << " <chart> <input log> [repeat]"
+              << std::endl;
+    return 1;
+  }
+
+  mystd::vector<KeyNoteData> keyNotes;
+  ChartParser chartParser(keyNotes);
+  if (!chartParser.load(argv[1]))
+    return 1;
+
+  InputLog log;
+  if (!log.load(argv[2]))
+    return 1;
+
+  // Logs of variable-tempo charts carry no mpf; take the chart's timing
+  TimingMap timing = log.msPerFragment
+                         ? TimingMap(log.msPerFragment)
+                         : chartParser.getTimingMap();
+  if (log.lanes == 0)
+    log.lanes = 4;
+  if (log.fragments == 0)
+    log.fragments = 10;
+
+  int repeat = argc > 3 ? std::atoi(argv[3]) : 1;
+  if (repeat < 1)
+    repeat = 1;
+
+  uint64_t simulatedMs = 0;
+  auto begin = std::chrono::steady_clock::now();
+
+  Game *game = nullptr;
+  for (int i = 0; i < repeat; ++i) {
+    delete game;
+    game = new Game(log.lanes, log.fragments, timing, keyNotes);
+    std::size_t total = chartLength(*game);
+    simulate(*game, log, total);
+    simulatedMs += game->fragmentMs(total);
+  }
+
+  auto end = std::chrono::steady_clock::now();
+  double wallMs =
+      std::chrono::duration<double, std::milli>(end - begin).count();
+
+  std::cout << "\n=== Replay Result ===" << std::endl;
+  std::cout << "Score: " << game->score << std::endl;
+  std::cout << "PERFECT: " << game->perfectCount
+            << ", GREAT: " << game->greatCount
+            << ", GOOD: " << game->goodCount << ", BAD: " << game->badCount
+            << ", MISS: " << game->missCount << std::endl;
+  std::cout << "MAX COMBO: " << game->maxCombo
+            << ", HELD TIME: " << game->heldTime << " ms" << std::endl;
+  std::cout << "Simulated " << simulatedMs << " ms in " << wallMs << " ms ("
+            << (wallMs > 0 ? simulatedMs / wallMs : 0) << "x realtime)"
+            << std::endl;
+
+  delete game;
+  return 0;
+}
@@ -1,17 +1,34 @@
-#include "Game.hpp"
+#include <algorithm>
 #include <cassert>
+#include <filesystem>
+#include <fstream>
+#include <functional>
 #include <iostream>
+#include <random>
+#include <thread>
+
+#include "include/algorithm-sort.hpp"
+
+#include "Bots.hpp"
+#include "ChartLibrary.hpp"
+#include "ChartParser.hpp"
+#include "CompiledChart.hpp"
+#include "Game.hpp"
+#include "InputQueue.hpp"
+#include "Replay.hpp"
+#include "Snapshot.hpp"
+#include "TimingMap.hpp"
+#include "ViewState.hpp"
 
 void testTapScoring() {
   std::cout << "=== Testing Tap Scoring ===" << std::endl;
 
-  Game game(1, 4, 100);
-
-  game.notes = {
+  mystd::vector<KeyNoteData> notes = {
       {0, 0, -1},
       {1, 0, -1},
       {2, 0, -1},
   };
+  Game game(1, 4, 100, notes);
 
   game.loadFragment();
   assert(game.highway[0][0] == -1);
@@ -57,8 +74,8 @@ void testHoldScenarios() {
 
   {
     std::cout << "Scenario 1: 3-fragment hold" << std::endl;
-    Game game(1, 5, 100);
-    game.notes = {{0, 0, 3}};
+    mystd::vector<KeyNoteData> notes = {{0, 0, 3}};
+    Game game(1, 5, 100, notes);
 
     game.loadFragment();
     assert(game.highway[0][0] == 3);
@@ -85,8 +102,8 @@ void testHoldScenarios() {
 
   {
     std::cout << "Scenario 2: Quick press/release" << std::endl;
-    Game game(1, 4, 100);
-    game.notes = {{0, 0, 2}};
+    mystd::vector<KeyNoteData> notes = {{0, 0, 2}};
+    Game game(1, 4, 100, notes);
 
     game.loadFragment();
     for (int i = 0; i < 3; i++)
@@ -106,8 +123,8 @@ void testHoldScenarios() {
 
   {
     std::cout << "Scenario 3: Hold until end" << std::endl;
-    Game game(1, 3, 100);
-    game.notes = {{0, 0, 2}};
+    mystd::vector<KeyNoteData> notes = {{0, 0, 2}};
+    Game game(1, 3, 100, notes);
 
     game.loadFragment();
     game.loadFragment();
@@ -140,12 +157,12 @@ void testHoldScenarios() {
 void testMixedNotes() {
   std::cout << "=== Testing Mixed Notes ===" << std::endl;
 
-  Game game(2, 4, 100);
-  game.notes = {
+  mystd::vector<KeyNoteData> notes = {
       {0, 0, -1},
       {0, 1, 2},
       {4, 0, 3},
   };
+  Game game(2, 4, 100, notes);
 
   uint64_t initialScore = game.score;
 
@@ -182,10 +199,10 @@ void testMixedNotes() {
 void testComboTracking() {
   std::cout << "=== Testing Combo Tracking ===" << std::endl;
 
-  Game game(1, 4, 100);
-  game.notes = {
+  mystd::vector<KeyNoteData> notes = {
       {0, 0, -1}, {1, 0, -1}, {2, 0, -1}, {3, 0, -1}, {4, 0, -1},
   };
+  Game game(1, 4, 100, notes);
 
   for (int i = 0; i < 4; i++)
     game.loadFragment();
@@ -210,9 +227,519 @@ void testComboTracking() {
   assert(game.combo == 2);
   assert(game.maxCombo == 2);
 
+  // Only the latest COMBO and SCORE effects stay live
+  assert(game.centerEffects.size() == 2);
+  for (const Effect &e : game.centerEffects) {
+    if (e.content == COMBO)
+      assert(e.num == 2);
+    else if (e.content == SCORE)
+      assert(e.num == game.score);
+  }
+  game.clearExpiredEffects(100000);
+  assert(game.centerEffects.empty());
+
   std::cout << "✓ Combo tracking test passed!" << std::endl << std::endl;
 }
 
+void testReplay() {
+  std::cout << "=== Testing Headless Replay ===" << std::endl;
+
+  mystd::vector<KeyNoteData> notes = {
+      {0, 0, -1}, {1, 1, -1}, {2, 0, 2}, {6, 1, -1}};
+
+  InputLog log;
+  log.reset(2, 4, 100);
+  log.record(410, 0, true);  // perfect
+  log.record(420, 0, false);
+  log.record(530, 1, true);  // great
+  log.record(540, 1, false);
+  log.record(610, 0, true);  // hold for 2 fragments
+  log.record(800, 0, false);
+  // note at fragment 6 is never hit -> miss
+
+  Game game(log.lanes, log.fragments, log.msPerFragment, notes);
+  std::size_t total = chartLength(game);
+  simulate(game, log, total);
+
+  assert(game.nowFragment == total);
+  assert(game.perfectCount == 1);
+  assert(game.greatCount == 1);
+  assert(game.missCount == 1);
+  assert(game.maxCombo == 2);
+  assert(game.heldTime == 190);
+
+  // Same input, same result
+  Game again(log.lanes, log.fragments, log.msPerFragment, notes);
+  simulate(again, log, total);
+  assert(again.score == game.score);
+
+  std::cout << "✓ Replay test passed!" << std::endl << std::endl;
+}
+
+void testBots() {
+  std::cout << "=== Testing Bots ===" << std::endl;
+
+  // Back-to-back holds: a noisy bot presses the next hold before it gets
+  // to the judgement line, which must not be worth more than pressing on
+  // time
+  mystd::vector<KeyNoteData> notes;
+  for (std::size_t f = 0; f < 200; f += 4) {
+    notes.push_back({f, 0, 3});
+    notes.push_back({f + 2, 1, 3});
+    notes.push_back({f + 1, 2, -1});
+  }
+  mystd::sort(notes.begin(), notes.end(),
+              [](const KeyNoteData &a, const KeyNoteData &b) {
+                return a.startFragment < b.startFragment;
+              });
+
+  Game game(3, 4, 100, notes);
+  std::size_t total = chartLength(game);
+  auto scoreOf = [&](const Bot &bot, unsigned seed) {
+    std::mt19937 rng(seed);
+    InputLog log;
+    bot.play(game, rng, log);
+    game.restart();
+    simulate(game, log, total);
+    return game.score;
+  };
+
+  uint32_t perfect = scoreOf(perfectBot(), 0);
+  for (unsigned seed = 0; seed < 20; ++seed) {
+    assert(scoreOf(humanBot(30.0, 0.03), seed) <= perfect);
+    assert(scoreOf(laneBiasedBot(20.0, 0.02, 2.0), seed) <= perfect);
+  }
+
+  std::cout << "✓ Bots test passed!" << std::endl << std::endl;
+}
+
+void testSeek() {
+  std::cout << "=== Testing Seek ===" << std::endl;
+
+  mystd::vector<KeyNoteData> notes = {{0, 0, -1}, {0, 1, 6}, {3, 2, -1},
+                                      {3, 0, 2},  {9, 1, -1}, {9, 2, 3},
+                                      {15, 0, -1}};
+
+  Game played(3, 4, 100, notes);
+  Game seeked(3, 4, 100, notes);
+
+  for (std::size_t f = 0; f < 20; ++f) {
+    seeked.seek(f);
+    for (std::size_t lane = 0; lane < 3; ++lane)
+      for (std::size_t i = 0; i < 4; ++i)
+        assert(seeked.highway[lane][i] == played.highway[lane][i]);
+    played.loadFragment();
+  }
+
+  seeked.restart();
+  assert(seeked.nowFragment == 0 && seeked.score == 0);
+  seeked.loadFragment();
+  assert(seeked.highway[0][0] == -1 && seeked.highway[1][0] == 6);
+
+  std::cout << "✓ Seek test passed!" << std::endl << std::endl;
+}
+
+void testLongHold() {
+  std::cout << "=== Testing Long Hold ===" << std::endl;
+
+  static_assert(sizeof(KeyNoteData) == 8);
+  mystd::vector<KeyNoteData> notes = {{0, 0, 300}, {2, 1, -1}, {150, 1, 200}};
+  assert(notes[0].holds == 300 && !notes[0].isTap() && notes[1].isTap());
+  KeyNoteData wide(1ull << 40, 300, 70000); // saturates, never wraps
+  assert(wide.startFragment == UINT32_MAX && wide.lane == 255);
+  assert(wide.holds == KeyNoteData::MAX_HOLD && !wide.isTap());
+
+  // Longer than a highway cell can count: seeking, stepping and snapshots
+  // must all agree on where the hold ends
+  Game played(2, 4, 100, notes);
+  Game seeked(2, 4, 100, notes);
+  SnapshotBuffer snaps;
+  for (std::size_t f = 0; f < 400; ++f) {
+    seeked.seek(f);
+    for (std::size_t lane = 0; lane < 2; ++lane)
+      for (std::size_t i = 0; i < 4; ++i)
+        assert(seeked.highway[lane][i] == played.highway[lane][i]);
+    if (f == 100)
+      assert(snaps.save(played));
+    played.loadFragment();
+    assert((played.highway[0][0] > 0) == (f < 300));
+    assert((played.highway[1][0] > 0) == (f >= 150 && f < 350));
+  }
+  assert(snaps.restore(played, 0));
+  for (std::size_t f = 100; f < 400; ++f) {
+    played.loadFragment();
+    assert((played.highway[0][0] > 0) == (f < 300));
+  }
+
+  // A bot holds it to the end
+  Game game(2, 4, 100, notes);
+  InputLog log;
+  std::mt19937 rng(3);
+  perfectBot().play(game, rng, log);
+  simulate(game, log, chartLength(game));
+  assert(game.missCount == 0 && game.heldTime >= 29000);
+
+  std::cout << "✓ Long hold test passed!" << std::endl << std::endl;
+}
+
+void testInputQueue() {
+  std::cout << "=== Testing Input Queue ===" << std::endl;
+
+  static InputQueue queue;
+  const uint32_t count = 100000;
+
+  std::thread producer([] {
+    for (uint32_t i = 0; i < count; ++i)
+      while (!queue.push({i, i % 4, (i & 1) == 0}))
+        std::this_thread::yield();
+  });
+
+  uint32_t expected = 0;
+  InputEvent e;
+  while (expected < count) {
+    if (queue.pop(e)) {
+      assert(e.timeMs == expected);
+      assert(e.lane == expected % 4);
+      assert(e.pressed == ((expected & 1) == 0));
+      ++expected;
+    }
+  }
+  producer.join();
+  assert(queue.empty());
+
+  std::cout << "✓ Input queue test passed!" << std::endl << std::endl;
+}
+
+void testSnapshot() {
+  std::cout << "=== Testing Snapshot ===" << std::endl;
+
+  mystd::vector<KeyNoteData> notes = {{0, 0, -1}, {1, 1, 3}, {2, 0, -1},
+                                      {4, 2, -1}, {5, 1, -1}};
+
+  InputLog log;
+  log.reset(3, 4, 100);
+  log.record(410, 0, true);
+  log.record(420, 0, false);
+  log.record(510, 1, true);
+  log.record(790, 1, false);
+  log.record(910, 1, true);
+
+  Game game(3, 4, 100, notes);
+  SnapshotBuffer snaps;
+  snaps.reserve(game, 2);
+  simulate(game, log, 5);
+  assert(snaps.save(game));
+  simulate(game, log, 8);
+  assert(snaps.save(game));
+  // Only the game's own 3 x 4 cells are stored
+  assert(snaps.recordBytes() == sizeof(SnapshotState) + 12);
+
+  simulate(game, log, 15);
+  uint32_t finalScore = game.score;
+  std::size_t finalMiss = game.missCount;
+
+  assert(snaps.restore(game, 0));
+  assert(game.nowFragment == 5);
+  simulate(game, log, 15);
+  assert(game.score == finalScore);
+  assert(game.missCount == finalMiss);
+
+  assert(snaps.restore(game, 1));
+  assert(game.nowFragment == 8);
+  simulate(game, log, 15);
+  assert(game.score == finalScore);
+
+  // Rolling back drops the later checkpoint; other sizes are refused
+  snaps.truncate(1);
+  assert(snaps.size() == 1 && !snaps.restore(game, 1));
+  Game other(4, 4, 100, notes);
+  assert(!snaps.save(other) && !snaps.restore(other, 0));
+
+  std::cout << "✓ Snapshot test passed!" << std::endl << std::endl;
+}
+
+void testViewState() {
+  std::cout << "=== Testing View State ===" << std::endl;
+
+  mystd::vector<KeyNoteData> notes = {{0, 0, -1}, {1, 1, 3}, {3, 2, -1}};
+  Game game(3, 4, 100, notes);
+  for (int i = 0; i < 5; ++i)
+    game.loadFragment();
+  game.keyPressed(1, 510);
+
+  ViewState view;
+  assert(saveView(game, 520, view));
+  for (std::size_t f = 0; f < game.fragments; ++f)
+    for (std::size_t lane = 0; lane < game.lanes; ++lane)
+      assert(view.row(f)[lane] == game.highway.row(f)[lane]);
+  assert(view.pressed(1) && !view.pressed(0));
+  assert(view.offsetMs(520) == 20);
+  assert(view.offsetMs(900) == 100);
+
+  // Reader only ever sees whole, increasingly recent values
+  struct Pair {
+    uint32_t a, b;
+  };
+  static TripleBuffer<Pair> buffer;
+  const uint32_t count = 100000;
+
+  std::thread writer([] {
+    for (uint32_t i = 1; i <= count; ++i) {
+      buffer.back() = {i, i};
+      buffer.publish();
+    }
+  });
+
+  uint32_t last = 0;
+  while (last < count) {
+    buffer.update();
+    const Pair &p = buffer.front();
+    assert(p.a == p.b);
+    assert(p.a >= last);
+    last = p.a;
+  }
+  writer.join();
+
+  std::cout << "✓ View state test passed!" << std::endl << std::endl;
+}
+
+void testChartParser() {
+  std::cout << "=== Testing Chart Parser ===" << std::endl;
+
+  mystd::vector<KeyNoteData> notes;
+  ChartParser parser(notes);
+  parser.parse("&bpm=150\r\n&fragments=2\n&music=./a b.mp3\n"
+               "&keynotes=\n# comment\n{8}\n 2 , 1/4 ,,3h[2],\n"
+               "{4}\nx,1\n&mousenotes=\nG1,R4/G9,\n");
+  assert(parser.getBPM() == 150);
+  assert(parser.getFragmentsPerBeat() == 2);
+  assert(parser.getMusicFile() == "./a b.mp3");
+
+  // {8} is one fragment per cell, {4} two; "x" is skipped but takes a cell
+  assert(notes.size() == 5);
+  assert(notes[0].startFragment == 0 && notes[0].lane == 1);
+  assert(notes[1].startFragment == 1 && notes[2].startFragment == 1);
+  assert(notes[3].startFragment == 3 && notes[3].lane == 2);
+  assert(notes[3].holds == 2);
+  assert(notes[4].startFragment == 6 && notes[4].isTap());
+
+  const auto &mouse = parser.getMouseNotes();
+  assert(mouse.size() == 2);
+  assert(mouse[0].lane == 0 && mouse[0].type == 0);
+  assert(mouse[1].startFragment == 2 && mouse[1].lane == 3);
+
+  std::cout << "✓ Chart parser test passed!" << std::endl << std::endl;
+}
+
+void testCompiledChart() {
+  std::cout << "=== Testing Compiled Chart ===" << std::endl;
+
+  std::filesystem::path dir =
+      std::filesystem::temp_directory_path() / "rq_chart_cache_test";
+  std::filesystem::remove_all(dir);
+  std::filesystem::create_directories(dir);
+  std::string chartPath = (dir / "chart.txt").string();
+  std::string cacheDir = (dir / "cache").string();
+  std::ofstream(chartPath) << "&bpm=90\n&music=m.ogg\n&keynotes=\n"
+                              "3,1h[2],2/4\n&mousenotes=\nR2,,G1\n";
+
+  mystd::vector<KeyNoteData> expected;
+  ChartParser parser(expected);
+  assert(parser.load(chartPath));
+
+  // Compiled on the first load, mapped from the cache on the second
+  for (int pass = 0; pass < 2; ++pass) {
+    CompiledChart chart;
+    assert(chart.load(chartPath, cacheDir));
+    assert(chart.getBPM() == 90 && chart.getMusicFile() == "m.ogg");
+    mystd::span<const KeyNoteData> keys = chart.getKeyNotes();
+    assert(keys.size() == expected.size());
+    for (std::size_t i = 0; i < keys.size(); ++i)
+      assert(keys[i].startFragment == expected[i].startFragment &&
+             keys[i].lane == expected[i].lane &&
+             keys[i].holds == expected[i].holds &&
+             keys[i].flags == expected[i].flags);
+    assert(chart.getMouseNotes().size() == 2);
+    assert(chart.getMouseNotes()[1].startFragment == 8);
+
+    Game game(4, 4, 100, chart.getKeyNotes());
+    assert(game.notes.size() == 4);
+  }
+
+  // A damaged cache file is rebuilt, not trusted
+  std::string cached = CompiledChart::cachePath(
+      cacheDir, hashChartText("&bpm=90\n&music=m.ogg\n&keynotes=\n"
+                              "3,1h[2],2/4\n&mousenotes=\nR2,,G1\n"));
+  assert(std::filesystem::exists(cached));
+  std::filesystem::resize_file(cached, 40);
+  CompiledChart chart;
+  assert(chart.load(chartPath, cacheDir));
+  assert(chart.getKeyNotes().size() == 4);
+  assert(std::filesystem::file_size(cached) > 40);
+
+  std::filesystem::remove_all(dir);
+  std::cout << "✓ Compiled chart test passed!" << std::endl << std::endl;
+}
+
+void testSort() {
+  std::cout << "=== Testing Sort ===" << std::endl;
+
+  std::mt19937 rng(7);
+  const std::size_t n = 50000;
+  mystd::vector<mystd::vector<int>> inputs(6);
+  for (std::size_t i = 0; i < n; ++i) {
+    inputs[0].push_back(rng() % 1000000);                 // random
+    inputs[1].push_back(i);                               // sorted
+    inputs[2].push_back(n - i);                           // descending
+    inputs[3].push_back(7);                               // all equal
+    inputs[4].push_back(i < n / 2 ? i : n - i);           // organ pipe
+    inputs[5].push_back(i % 100 == 0 ? rng() % n : i);    // nearly sorted
+  }
+
+  for (mystd::vector<int> &v : inputs) {
+    std::vector<int> expected(v.begin(), v.end());
+    std::sort(expected.begin(), expected.end());
+    std::size_t compares = 0;
+    mystd::sort(v.begin(), v.end(), [&](int a, int b) {
+      ++compares;
+      return a < b;
+    });
+    assert(std::equal(v.begin(), v.end(), expected.begin()));
+    assert(compares < 4 * n * 17); // O(n log n), log2(50000) < 16
+  }
+
+  // Sorted notes, what the chart parser produces, take a single pass
+  mystd::vector<KeyNoteData> notes;
+  for (std::size_t i = 0; i < n; ++i)
+    notes.push_back({i / 3, i % 4, -1});
+  std::size_t compares = 0;
+  mystd::sort(notes.begin(), notes.end(),
+              [&](const KeyNoteData &a, const KeyNoteData &b) {
+                ++compares;
+                return a.startFragment < b.startFragment;
+              });
+  assert(compares == n - 1);
+  assert(notes[0].lane == 0 && notes[1].lane == 1);
+
+  std::cout << "✓ Sort test passed!" << std::endl << std::endl;
+}
+
+void testTimingMap() {
+  std::cout << "=== Testing Timing Map ===" << std::endl;
+
+  // 60 BPM, 4 fragments per beat: 250 ms per fragment. 120 BPM from beat 2
+  // (fragment 8), then a 500 ms stop before beat 4 (fragment 16).
+  mystd::vector<KeyNoteData> notes;
+  ChartParser parser(notes);
+  parser.parse("&bpm=60\n&fragments=4\n&stop=4,500\n&bpmchange=2,120\n"
+               "&keynotes=\n{16}\n1,2,1,2,1h[2],2,1,2,1,2,1,2,1,2,1,2,\n"
+               "1,2,1,2,1,2,1,2\n");
+  const TimingMap &timing = parser.getTimingMap();
+  assert(timing.getSections().size() == 3);
+  assert(timing.timeOf(4) == 1000 && timing.timeOf(8) == 2000);
+  assert(timing.timeOf(9) == 2125 && timing.timeOf(16) == 3500);
+  assert(timing.fragmentAt(2125) == 9);
+  assert(timing.fragmentAt(3200) == 16); // waits out the stop
+  assert(timing.fragmentAt(3625) == 17);
+  assert(timing.uniformMs() == 0 && TimingMap(100).uniformMs() == 100);
+
+  // Random jumps miss the remembered section and fall back to the search
+  std::mt19937 rng(5);
+  for (int i = 0; i < 1000; ++i) {
+    std::size_t f = rng() % 40;
+    double expected = f <= 8    ? f * 250.0
+                      : f < 16 ? 2000 + (f - 8) * 125.0
+                               : 3500 + (f - 16) * 125.0;
+    assert(timing.timeOf(f) == expected);
+    assert(timing.fragmentAt(expected) == f);
+  }
+
+  // A bot timed by the map hits every tap across both tempos and the stop
+  Game game(2, 4, timing, notes);
+  InputLog log;
+  perfectBot().play(game, rng, log);
+  assert(log.msPerFragment == 0);
+  std::size_t total = chartLength(game);
+  simulate(game, log, total);
+  assert(game.perfectCount == notes.size() - 1); // holds are not judged
+  assert(game.missCount == 0 && game.heldTime > 0);
+  assert(game.nowFragment == total);
+
+  std::cout << "✓ Timing map test passed!" << std::endl << std::endl;
+}
+
+void testChartLibrary() {
+  std::cout << "=== Testing Chart Library ===" << std::endl;
+
+  std::filesystem::path dir =
+      std::filesystem::temp_directory_path() / "rq_chart_library_test";
+  std::filesystem::remove_all(dir);
+  std::filesystem::create_directories(dir / "pack");
+  std::filesystem::create_directories(dir / ".cache");
+  std::string indexPath = (dir / ".cache" / "library.idx").string();
+  auto writeChart = [](const std::filesystem::path &path, int bpm) {
+    std::ofstream(path) << "&bpm=" << bpm << "\n&fragments=2\n"
+                        << "&music=song.ogg\n&keynotes=\n{8}\n1,2,3h[2],4\n"
+                        << "&mousenotes=\nG1\n";
+  };
+  for (int i = 0; i < 20; ++i)
+    writeChart(dir / "pack" / ("c" + std::to_string(i) + ".txt"), 60 + i);
+  writeChart(dir / "a.txt", 120);
+  writeChart(dir / ".cache" / "ignored.txt", 120);
+  // No header at all: 120 BPM, 4 fragments per beat, no music
+  std::ofstream(dir / "bare.txt") << "&keynotes=\n1\n";
+  std::ofstream(dir / "notes.md") << "not a chart";
+
+  // Workers reuse one parser; a chart without metadata must not inherit
+  // the previous chart's
+  auto checkBare = [](const ChartInfo &bare) {
+    assert(bare.bpm == 120 && bare.fragmentsPerBeat == 4);
+    assert(bare.musicFile.empty() && bare.durationMs == 125);
+  };
+
+  ChartLibrary library;
+  LibraryScanStats cold = library.scan(dir.string(), indexPath, 1);
+  assert(cold.charts == 22 && cold.parsed == 22 && cold.reused == 0);
+  std::size_t a = library.find((dir / "a.txt").string(), 99);
+  assert(a == 0);
+  // 120 BPM at 2 fragments per beat; the hold ends at fragment 2 + 2
+  assert(library[a].bpm == 120 && library[a].keyNotes == 4);
+  assert(library[a].mouseNotes == 1 && library[a].lengthFragments == 4);
+  assert(library[a].durationMs == 1000 && library[a].musicFile == "song.ogg");
+  std::size_t bare = library.find((dir / "bare.txt").string(), 99);
+  assert(bare == 1);
+  checkBare(library[bare]);
+
+  ChartLibrary warm;
+  LibraryScanStats again = warm.scan(dir.string(), indexPath, 4);
+  assert(again.charts == 22 && again.reused == 22 && again.parsed == 0);
+  assert(warm[a].durationMs == 1000 && warm[a].path == library[a].path);
+  checkBare(warm[bare]);
+
+  // Only the changed charts are read again; deleted ones drop out
+  writeChart(dir / "a.txt", 1200); // new size, whatever the mtime resolution
+  std::ofstream(dir / "bare.txt") << "&keynotes=\n\n1\n";
+  std::filesystem::remove(dir / "pack" / "c0.txt");
+  LibraryScanStats changed = warm.scan(dir.string(), indexPath, 1);
+  assert(changed.charts == 21 && changed.parsed == 2 && changed.reused == 19);
+  assert(warm[0].bpm == 1200 && warm[0].durationMs == 100);
+  checkBare(warm[1]);
+
+  // The same parser, straight after a chart with every header line
+  mystd::vector<KeyNoteData> notes;
+  ChartParser parser(notes);
+  parser.parse("&bpm=200\n&offset=500\n&music=z.ogg\n&fragments=8\n"
+               "&bpmchange=1,100\n&keynotes=\n1\n");
+  parser.parse("&keynotes=\n1\n");
+  assert(parser.getBPM() == 120 && parser.getOffset() == 0);
+  assert(parser.getFragmentsPerBeat() == 4 && parser.getMusicFile().empty());
+  assert(parser.getTimingMap().getSections().size() == 1);
+  assert(parser.getFragmentTime(1) == 125);
+
+  std::filesystem::remove_all(dir);
+  std::cout << "✓ Chart library test passed!" << std::endl << std::endl;
+}
+
 int main() {
   try {
     std::cout << "Starting Game tests..." << std::endl;
@@ -221,6 +748,18 @@ int main() {
     testHoldScenarios();
     testMixedNotes();
     testComboTracking();
+    testReplay();
+    testBots();
+    testSeek();
+    testLongHold();
+    testInputQueue();
+    testSnapshot();
+    testViewState();
+    testSort();
+    testChartParser();
+    testCompiledChart();
+    testTimingMap();
+    testChartLibrary();
 
     std::cout << "=== All tests passed! ===" << std::endl;
     return 0;
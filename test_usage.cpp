@@ -43,7 +43,8 @@ int main(int argc, char* argv[]) {
     // 2. Test Chart Parser
     // ========================================
     std::cout << "\n--- Testing Chart Parser ---" << std::endl;
-    ChartParser parser;
+    mystd::vector<KeyNoteData> keyNotes;
+    ChartParser parser(keyNotes);
     
     if (!parser.load("./chart/test_chart.txt")) {
         std::cerr << "[ERROR] Failed to load chart file" << std::endl;
@@ -62,8 +63,6 @@ int main(int argc, char* argv[]) {
     std::cout << "  Data for Willie (Key Notes)" << std::endl;
     std::cout << "========================================" << std::endl;
     
-    const std::vector<KeyNoteData>& keyNotes = parser.getKeyNotes();
-    
     std::cout << "Total key notes: " << keyNotes.size() << std::endl;
     std::cout << "\nFirst 10 notes:" << std::endl;
     std::cout << "Index\tFragment\tLane\tHolds\tTime(ms)" << std::endl;
@@ -73,9 +72,9 @@ int main(int argc, char* argv[]) {
         const auto& note = keyNotes[i];
         std::cout << i << "\t"
                   << note.startFragment << "\t\t"
-                  << note.lane << "\t";
+                  << (int)note.lane << "\t";
         
-        if (note.holds == -1) {
+        if (note.isTap()) {
             std::cout << "TAP";
         } else {
             std::cout << note.holds;
@@ -88,8 +87,8 @@ int main(int argc, char* argv[]) {
     std::cout << "  for (const auto& note : keyNotes) {" << std::endl;
     std::cout << "    if (currentFragment == note.startFragment) {" << std::endl;
     std::cout << "      // Generate note at lane: note.lane (0-3)" << std::endl;
-    std::cout << "      // If note.holds == -1  -> TAP note" << std::endl;
-    std::cout << "      // If note.holds > 0    -> HOLD note (duration in fragments)" << std::endl;
+    std::cout << "      // If note.isTap()      -> TAP note" << std::endl;
+    std::cout << "      // Otherwise note.holds -> HOLD note (duration in fragments)" << std::endl;
     std::cout << "    }" << std::endl;
     std::cout << "  }" << std::endl;
 